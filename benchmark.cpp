@@ -0,0 +1,102 @@
+#include "benchmark.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QThread>
+
+#include <algorithm>
+#include <limits>
+
+static QLoggingCategory lc{"multicnnclassifier.benchmark"};
+
+static constexpr qint64 MIN_BATCH_NS = 1000000;
+static constexpr int MAX_BATCH_SIZE = 1 << 20;
+static constexpr int BATCHES = 20;
+
+/**
+ * @brief Measures a component
+ * @param name Name of the component
+ * @param parameter Size of the input, e.g. the number of ROIs
+ * @param function Runs the component once
+ * @return Result with the time per run of the best and the mean batch in ns
+ *
+ * The runs are grouped to batches of at least 1 ms, so the timer resolution does not matter. The best batch is the
+ * time with the least disturbance by other threads, the mean the typical time.
+ */
+template <typename Function>
+static QJsonObject measure(const QString& name, const QJsonValue& parameter, Function function) {
+    QElapsedTimer timer;
+    auto batchSize = 1;
+    for (;;) {
+        timer.start();
+        for (auto run = 0; run < batchSize; run++) {
+            function();
+        }
+        if (timer.nsecsElapsed() >= MIN_BATCH_NS || batchSize >= MAX_BATCH_SIZE) {
+            break;
+        }
+        batchSize *= 2;
+    }
+
+    auto bestNs = std::numeric_limits<qint64>::max();
+    qint64 totalNs = 0;
+    for (auto batch = 0; batch < BATCHES; batch++) {
+        timer.start();
+        for (auto run = 0; run < batchSize; run++) {
+            function();
+        }
+        const auto elapsedNs = timer.nsecsElapsed();
+        bestNs = std::min(bestNs, elapsedNs);
+        totalNs += elapsedNs;
+    }
+
+    return QJsonObject{{"Name", name},
+                       {"Parameter", parameter},
+                       {"Runs", batchSize * BATCHES},
+                       {"BestNs", static_cast<double>(bestNs) / batchSize},
+                       {"MeanNs", static_cast<double>(totalNs) / (batchSize * BATCHES)}};
+}
+
+Benchmark::Benchmark(CnnRoiHandler& cnnRoiHandler)
+  : _cnnRoiHandler{cnnRoiHandler}
+  , _run{"benchmark", false}
+  , _resultFile{"benchmarkfile", false, true, "json"} {
+    _resultFile.setZIndex(4);
+    _resultFile.setFilter({"Json |*.json"});
+    connect(&_run, &IDS::NXT::ConfigurableBool::changed, this, &Benchmark::run);
+}
+
+void Benchmark::run(bool enable) {
+    if (!enable) {
+        return;
+    }
+    qCInfo(lc) << "Benchmark started";
+    QElapsedTimer timer;
+    timer.start();
+
+    QJsonArray results;
+    benchmarkDescription(results);
+
+    const QJsonObject report{{"Timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+                             {"QtVersion", QString(qVersion())},
+                             {"Cores", QThread::idealThreadCount()},
+                             {"Results", results}};
+    QFile file(_resultFile.absoluteFilePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lc) << "Can not write benchmark to" << file.fileName();
+        return;
+    }
+    file.write(QJsonDocument(report).toJson());
+    file.close();
+    qCInfo(lc) << "Benchmark written to" << file.fileName() << "after" << timer.elapsed() << "ms";
+}
+
+void Benchmark::benchmarkDescription(QJsonArray& results) {
+    results.append(measure(QStringLiteral("installedCnnDescription"), QJsonValue{}, [this]() {
+        _cnnRoiHandler.installedCnnDescription();
+    }));
+}
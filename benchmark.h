@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QJsonArray>
+#include <QObject>
+
+#include <configurablebool.h>
+#include <configurablefile.h>
+
+#include "cnnroihandler.h"
+
+/**
+ * @brief Micro-benchmark of the components which need the NXT framework
+ *
+ * Only rebuilding the CNN description is measured here, because it queries the CNN manager of the camera. The
+ * components which do without the framework are benchmarked by the desktop project in tests/benchmark. The results
+ * are written as JSON to a downloadable file, so they can be compared across releases.
+ */
+class Benchmark : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief C'tor
+     * @param cnnRoiHandler The handler whose CNN description is rebuilt by the benchmark
+     */
+    explicit Benchmark(CnnRoiHandler& cnnRoiHandler);
+
+private slots:
+    /**
+     * @brief Runs the benchmark when switched on
+     * @param enable Flag of the switch
+     *
+     * The benchmark runs in the main thread, which queries the CNN manager. Images are still processed meanwhile,
+     * they compete for the cores with it.
+     */
+    void run(bool enable);
+
+private:
+    void benchmarkDescription(QJsonArray& results);
+
+    CnnRoiHandler& _cnnRoiHandler;
+    IDS::NXT::ConfigurableBool _run;
+    IDS::NXT::ConfigurableFile _resultFile;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free queue for several producers and consumers
+ *
+ * Every cell carries a sequence number which tells producers and consumers whose turn it is, so both sides only
+ * need one compare-and-swap on their position. A full queue rejects the element instead of blocking the producer.
+ * The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief C'tor
+     * @param capacity Minimum number of elements the queue holds
+     */
+    explicit BoundedQueue(size_t capacity)
+      : _mask{roundUp(capacity) - 1}
+      , _cells{new Cell[_mask + 1]} {
+        for (size_t pos = 0; pos <= _mask; pos++) {
+            _cells[pos].sequence.store(pos, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Appends an element
+     * @param value Element
+     * @return False if the queue is full, the element is not taken then
+     */
+    bool push(T&& value) {
+        auto pos = _enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& cell = _cells[pos & _mask];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Takes the oldest element
+     * @param value Receives the element
+     * @return False if the queue is empty
+     */
+    bool pop(T& value) {
+        auto pos = _dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& cell = _cells[pos & _mask];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.value = T();
+                    cell.sequence.store(pos + _mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Getter for the number of queued elements
+     * @return Approximate number, the queue may change concurrently
+     */
+    size_t size() const {
+        const auto enqueued = _enqueuePos.load(std::memory_order_relaxed);
+        const auto dequeued = _dequeuePos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUp(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        return rounded;
+    }
+
+    const size_t _mask;
+    const std::unique_ptr<Cell[]> _cells;
+    // the positions are written by different threads, so they are kept on different cache lines
+    alignas(64) std::atomic<size_t> _enqueuePos{0};
+    alignas(64) std::atomic<size_t> _dequeuePos{0};
+};
@@ -0,0 +1,45 @@
+#include "cameramodel.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+CameraModel::CameraModel(const QSize& sensorSize, double lineTimeUs, double frameOverheadUs, const QSize& alignment)
+  : _sensorSize{sensorSize}
+  , _lineTimeUs{lineTimeUs}
+  , _frameOverheadUs{frameOverheadUs}
+  , _alignment{std::max(alignment.width(), 1), std::max(alignment.height(), 1)}
+  , _aoi{QPoint(0, 0), sensorSize} {}
+
+void CameraModel::setAoi(const SensorAoi& aoi) {
+    const auto rect = aoi.isReduced() ? aoi.rect() : QRect(QPoint(0, 0), _sensorSize);
+    if (!QRect(QPoint(0, 0), _sensorSize).contains(rect)) {
+        throw std::runtime_error("AOI exceeds the sensor of " + std::to_string(_sensorSize.width()) + " x "
+                                 + std::to_string(_sensorSize.height()) + " px");
+    }
+    const auto alignedX = rect.x() % _alignment.width() == 0 && rect.width() % _alignment.width() == 0;
+    const auto alignedY = rect.y() % _alignment.height() == 0 && rect.height() % _alignment.height() == 0;
+    if (!alignedX || !alignedY) {
+        throw std::runtime_error("AOI does not match the granularity of " + std::to_string(_alignment.width()) + " x "
+                                 + std::to_string(_alignment.height()) + " px");
+    }
+
+    _aoi = rect;
+}
+
+QRect CameraModel::aoi() const {
+    return _aoi;
+}
+
+QImage CameraModel::readOut(const QImage& scene) const {
+    return scene.copy(_aoi);
+}
+
+double CameraModel::readoutTimeUs() const {
+    // the sensor reads out whole lines, so only the number of lines counts
+    return _frameOverheadUs + _aoi.height() * _lineTimeUs;
+}
+
+double CameraModel::maxFrameRate() const {
+    return 1e6 / readoutTimeUs();
+}
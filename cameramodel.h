@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QImage>
+#include <QRect>
+#include <QSize>
+
+#include "sensoraoi.h"
+
+/**
+ * @brief Stand-in for the sensor readout of a camera
+ *
+ * Models a rolling readout of sensor lines with an AOI, so AOI configurations can be checked offline without a
+ * camera: AOIs are validated like the sensor does, images are read out to the AOI and the readout time and frame
+ * rate follow the number of lines. The figures are a model, not the timing of a real sensor.
+ */
+class CameraModel {
+public:
+    /**
+     * @brief C'tor
+     * @param sensorSize Size of the full sensor in px
+     * @param lineTimeUs Readout time of one sensor line in us
+     * @param frameOverheadUs Fixed time per frame in us, e.g. for the exposure start and the frame transfer
+     * @param alignment Granularity of the AOI offset and size
+     */
+    CameraModel(const QSize& sensorSize,
+                double lineTimeUs,
+                double frameOverheadUs = 0.,
+                const QSize& alignment = SensorAoi::defaultAlignment());
+
+    /**
+     * @brief Programs the AOI
+     * @param aoi AOI to read out, the full sensor if it is not reduced
+     *
+     * Throws a std::runtime_error if the AOI does not fit into the sensor or does not match the granularity.
+     */
+    void setAoi(const SensorAoi& aoi);
+
+    /**
+     * @brief Getter for the programmed AOI
+     * @return AOI in sensor coordinates
+     */
+    QRect aoi() const;
+
+    /**
+     * @brief Reads out an image
+     * @param scene Image of the full sensor
+     * @return Part of the scene inside of the AOI, as the camera delivers it
+     */
+    QImage readOut(const QImage& scene) const;
+
+    /**
+     * @brief Getter for the readout time of a frame
+     * @return Time in us
+     */
+    double readoutTimeUs() const;
+
+    /**
+     * @brief Getter for the maximum frame rate
+     * @return Frames per second limited by the readout
+     */
+    double maxFrameRate() const;
+
+private:
+    QSize _sensorSize;
+    double _lineTimeUs;
+    double _frameOverheadUs;
+    QSize _alignment;
+    QRect _aoi;
+};
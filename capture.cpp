@@ -0,0 +1,461 @@
+#include "capture.h"
+
+#include <QHash>
+#include <QLoggingCategory>
+#include <QMap>
+#include <QPair>
+#include <QStringList>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+#include "cnnroihandler.h"
+#include "myvision.h"
+#include "workerpool.h"
+
+static QLoggingCategory lc{"multicnnclassifier.capture"};
+
+static constexpr char CAPTURE_MAGIC[4] = {'M', 'C', 'C', 'R'};
+static constexpr quint32 CAPTURE_VERSION = 1;
+static constexpr quint32 FRAME_MAGIC = 0x4d415246; // "FRAM"
+static constexpr qint64 ALIGNMENT = 8;
+static constexpr int MAX_SCALING_SHARDS = 4;
+
+namespace {
+struct FileHeader {
+    char magic[4];
+    quint32 version;
+    qint64 usedBytes; // header and all frames
+};
+
+struct FrameHeader {
+    quint32 magic;
+    quint32 inputCount;
+    qint64 timeNs;
+    qint64 size; // header, input headers and data
+};
+
+struct InputHeader {
+    qint32 roi;
+    qint32 stage;
+    qint32 width;
+    qint32 height;
+    qint32 format;
+    qint32 bytesPerLine;
+};
+
+qint64 aligned(qint64 size) {
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/**
+ * @brief Checks that the inputs of a recorded frame describe images inside the frame
+ * @param frameData Start of the frame
+ * @param frameHeader Header of the frame, its size is already checked against the file
+ * @return False if an input header is out of range, e.g. of a truncated or edited file
+ */
+bool validFrame(const uchar* frameData, const FrameHeader& frameHeader) {
+    auto pos = aligned(sizeof(FrameHeader));
+    for (quint32 cnt = 0; cnt < frameHeader.inputCount; cnt++) {
+        if (pos + static_cast<qint64>(sizeof(InputHeader)) > frameHeader.size) {
+            return false;
+        }
+        InputHeader inputHeader{};
+        std::memcpy(&inputHeader, frameData + pos, sizeof(inputHeader));
+        pos += aligned(sizeof(InputHeader));
+
+        if (inputHeader.roi < 0 || inputHeader.roi >= CnnRoiConfig::getMaxRois() || inputHeader.stage < 0
+            || inputHeader.width <= 0 || inputHeader.height <= 0 || inputHeader.format <= QImage::Format_Invalid
+            || inputHeader.format >= QImage::NImageFormats) {
+            return false;
+        }
+        const auto bitsPerPixel = static_cast<qint64>(
+            QImage::toPixelFormat(static_cast<QImage::Format>(inputHeader.format)).bitsPerPixel());
+        const auto minBytesPerLine = (inputHeader.width * bitsPerPixel + 7) / 8;
+        if (bitsPerPixel <= 0 || inputHeader.bytesPerLine < minBytesPerLine) {
+            return false;
+        }
+        pos += aligned(static_cast<qint64>(inputHeader.bytesPerLine) * inputHeader.height);
+        if (pos > frameHeader.size) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+CaptureWriter::CaptureWriter(const QString& fileName, qint64 capacity)
+  : _file{fileName}
+  , _capacity{capacity} {
+    if (!_file.open(QIODevice::ReadWrite | QIODevice::Truncate) || !_file.resize(_capacity)) {
+        throw std::runtime_error("Can not create capture file " + fileName.toStdString());
+    }
+    _data = _file.map(0, _capacity);
+    if (!_data) {
+        throw std::runtime_error("Can not map capture file " + fileName.toStdString());
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    std::memcpy(_data, &header, sizeof(header));
+    _used = aligned(sizeof(FileHeader));
+    _clock.start();
+}
+
+CaptureWriter::~CaptureWriter() {
+    // Shrink the file to the recorded frames, a reservation beyond the capacity was not written
+    const auto used = std::min(_used.load(), _capacity);
+    std::memcpy(_data + offsetof(FileHeader, usedBytes), &used, sizeof(used));
+    _file.unmap(_data);
+    _file.resize(used);
+    _file.close();
+    qCDebug(lc) << "Capture file written with" << used << "bytes";
+}
+
+bool CaptureWriter::recordFrame(const QVector<QVector<QImage>>& inputs) {
+    const auto timeNs = _clock.nsecsElapsed();
+
+    auto size = aligned(sizeof(FrameHeader));
+    auto inputCount = 0;
+    for (const auto& roiInputs : inputs) {
+        for (const auto& input : roiInputs) {
+            size += aligned(sizeof(InputHeader)) + aligned(input.sizeInBytes());
+            inputCount++;
+        }
+    }
+
+    // Reserve the space of the frame, once the file is full all further reservations fail as well
+    const auto offset = _used.fetch_add(size);
+    if (offset + size > _capacity) {
+        return false;
+    }
+
+    auto* frameData = _data + offset;
+    const FrameHeader frameHeader{FRAME_MAGIC, static_cast<quint32>(inputCount), timeNs, size};
+    std::memcpy(frameData, &frameHeader, sizeof(frameHeader));
+    auto pos = aligned(sizeof(FrameHeader));
+    for (auto roi = 0; roi < inputs.size(); roi++) {
+        for (auto stage = 0; stage < inputs.at(roi).size(); stage++) {
+            const auto& input = inputs.at(roi).at(stage);
+            const InputHeader inputHeader{roi,
+                                          stage,
+                                          input.width(),
+                                          input.height(),
+                                          static_cast<qint32>(input.format()),
+                                          static_cast<qint32>(input.bytesPerLine())};
+            std::memcpy(frameData + pos, &inputHeader, sizeof(inputHeader));
+            pos += aligned(sizeof(InputHeader));
+            std::memcpy(frameData + pos, input.constBits(), static_cast<size_t>(input.sizeInBytes()));
+            pos += aligned(input.sizeInBytes());
+        }
+    }
+
+    return true;
+}
+
+CaptureReader::CaptureReader(const QString& fileName)
+  : _file{fileName} {
+    if (!_file.open(QIODevice::ReadOnly)) {
+        throw std::runtime_error("Can not open capture file " + fileName.toStdString());
+    }
+    _size = _file.size();
+    if (_size < static_cast<qint64>(sizeof(FileHeader))) {
+        throw std::runtime_error("Not a capture file");
+    }
+    _data = _file.map(0, _size);
+    if (!_data) {
+        throw std::runtime_error("Can not map capture file " + fileName.toStdString());
+    }
+
+    FileHeader header{};
+    std::memcpy(&header, _data, sizeof(header));
+    if (std::memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 || header.version != CAPTURE_VERSION) {
+        throw std::runtime_error("Not a capture file");
+    }
+
+    // Frames were recorded in parallel, so they are sorted by time for the replay
+    QVector<QPair<qint64, qint64>> frames;
+    auto offset = aligned(sizeof(FileHeader));
+    const auto used = std::min(header.usedBytes, _size);
+    while (offset + static_cast<qint64>(sizeof(FrameHeader)) <= used) {
+        FrameHeader frameHeader{};
+        std::memcpy(&frameHeader, _data + offset, sizeof(frameHeader));
+        if (frameHeader.magic != FRAME_MAGIC || frameHeader.size <= 0 || offset + frameHeader.size > used
+            || !validFrame(_data + offset, frameHeader)) {
+            qCWarning(lc) << "Capture file truncated at" << offset;
+            break;
+        }
+        frames.append(qMakePair(frameHeader.timeNs, offset));
+        offset += frameHeader.size;
+    }
+    std::sort(frames.begin(), frames.end());
+    for (const auto& frame : qAsConst(frames)) {
+        _frameOffsets.append(frame.second);
+    }
+}
+
+int CaptureReader::frameCount() const {
+    return _frameOffsets.size();
+}
+
+CaptureReader::Frame CaptureReader::frame(int index) const {
+    const auto* frameData = _data + _frameOffsets.at(index);
+    FrameHeader frameHeader{};
+    std::memcpy(&frameHeader, frameData, sizeof(frameHeader));
+
+    Frame frame;
+    frame.timeNs = frameHeader.timeNs;
+    auto pos = aligned(sizeof(FrameHeader));
+    for (quint32 cnt = 0; cnt < frameHeader.inputCount; cnt++) {
+        InputHeader inputHeader{};
+        std::memcpy(&inputHeader, frameData + pos, sizeof(inputHeader));
+        pos += aligned(sizeof(InputHeader));
+
+        QImage input(frameData + pos,
+                     inputHeader.width,
+                     inputHeader.height,
+                     inputHeader.bytesPerLine,
+                     static_cast<QImage::Format>(inputHeader.format));
+        if (input.format() == QImage::Format_Indexed8) {
+            // the color table is not recorded, the CNN inputs of indexed images are gray
+            QVector<QRgb> grayTable;
+            for (auto value = 0; value < 256; value++) {
+                grayTable.append(qRgb(value, value, value));
+            }
+            input.setColorTable(grayTable);
+        }
+        pos += aligned(input.sizeInBytes());
+
+        if (frame.inputs.size() <= inputHeader.roi) {
+            frame.inputs.resize(inputHeader.roi + 1);
+        }
+        frame.inputs[inputHeader.roi].append(input);
+    }
+
+    return frame;
+}
+
+Capture::Capture(CnnRoiHandler& cnnRoiHandler)
+  : _cnnRoiHandler{cnnRoiHandler}
+  , _recording{"recording", false}
+  , _replay{"replay", false}
+  , _captureFile{"capturefile", false, true, "mcc"} {
+    _captureFile.setZIndex(3);
+    _captureFile.setFilter({"Capture |*.mcc"});
+    _captureFile.setDeletable(true);
+    connect(&_recording, &IDS::NXT::ConfigurableBool::changed, this, &Capture::enableRecording);
+    connect(&_replay, &IDS::NXT::ConfigurableBool::changed, this, &Capture::enableReplay);
+}
+
+Capture::~Capture() {
+    stopReplay();
+}
+
+std::shared_ptr<CaptureWriter> Capture::writer() const {
+    return _writer.load();
+}
+
+void Capture::enableRecording(bool enable) {
+    std::shared_ptr<CaptureWriter> writer;
+    if (enable) {
+        // the file can not be replayed and recorded at the same time
+        stopReplay();
+        const auto capacity = static_cast<qint64>(_cnnRoiHandler.settings().captureSizeMb()) * 1024 * 1024;
+        writer = std::make_shared<CaptureWriter>(_captureFile.absoluteFilePath(), capacity);
+    }
+    // the file is finalized when the last vision object released the previous writer
+    _writer.store(std::move(writer));
+}
+
+void Capture::enableReplay(bool enable) {
+    stopReplay();
+    if (!enable) {
+        return;
+    }
+    if (writer()) {
+        throw std::runtime_error("Can not replay while recording");
+    }
+
+    _stopReplay = false;
+    const auto originalRate = _cnnRoiHandler.settings().replayOriginalRate();
+    _replayThread = std::thread(&Capture::replay, this, _captureFile.absoluteFilePath(), originalRate);
+}
+
+void Capture::stopReplay() {
+    _stopReplay = true;
+    if (_replayThread.joinable()) {
+        _replayThread.join();
+    }
+}
+
+/**
+ * @brief Measures the throughput of the recorded frames with the ROIs split across 1 to MAX_SCALING_SHARDS shards
+ * @param reader Capture file
+ * @param roiCnnList Active configuration, the frames which do not fit it are skipped
+ * @param stop Flag to stop the measurement
+ * @return Frames per second by number of shards starting with 1, shorter if the measurement was stopped
+ *
+ * The ROIs are split by their CNN like the engines split them, one vision object per shard. The shards of a frame
+ * run in parallel like the engines do, so the figures show how far sharding scales with this configuration.
+ */
+static QVector<double> measureShardScaling(const CaptureReader& reader,
+                                           const MyVision::RoiCnnListPtr& roiCnnList,
+                                           const std::atomic_bool& stop) {
+    QVector<double> fpsByShards;
+    for (auto shards = 1; shards <= MAX_SCALING_SHARDS && !stop; shards++) {
+        // distinct CNNs are distributed round robin
+        QHash<QString, int> shardOfCnn;
+        QVector<MyVision::RoiCnnList> shardLists(shards);
+        QVector<QVector<int>> shardRois(shards);
+        for (auto roi = 0; roi < roiCnnList->size(); roi++) {
+            const auto& roiCnn = roiCnnList->at(roi);
+            const auto& cnn = roiCnn.descriptor->name();
+            if (!shardOfCnn.contains(cnn)) {
+                shardOfCnn.insert(cnn, shardOfCnn.size() % shards);
+            }
+            const auto shard = shardOfCnn.value(cnn);
+            shardLists[shard].append(roiCnn);
+            shardRois[shard].append(roi);
+        }
+
+        QVector<QVector<QVector<QImage>>> shardInputs(shards);
+        std::vector<std::shared_ptr<MyVision>> visions;
+        std::vector<WorkerPool::Task> tasks;
+        for (auto shard = 0; shard < shards; shard++) {
+            auto vision = std::make_shared<MyVision>();
+            vision->setCnnData(std::make_shared<const MyVision::RoiCnnList>(shardLists.at(shard)));
+            visions.push_back(vision);
+            tasks.emplace_back([vision, &shardInputs, shard]() { vision->replay(shardInputs.at(shard)); });
+        }
+        WorkerPool workers(shards - 1);
+
+        QElapsedTimer clock;
+        clock.start();
+        auto frames = 0;
+        for (auto index = 0; index < reader.frameCount() && !stop; index++) {
+            const auto frame = reader.frame(index);
+            if (frame.inputs.size() != roiCnnList->size()) {
+                continue;
+            }
+            for (auto shard = 0; shard < shards; shard++) {
+                auto& inputs = shardInputs[shard];
+                inputs.clear();
+                for (const auto roi : qAsConst(shardRois.at(shard))) {
+                    inputs.append(frame.inputs.at(roi));
+                }
+            }
+            workers.run(tasks);
+            frames++;
+        }
+        if (!stop) {
+            fpsByShards.append(frames * 1000. / std::max<qint64>(clock.elapsed(), 1));
+        }
+    }
+
+    return fpsByShards;
+}
+
+void Capture::replay(const QString& fileName, bool originalRate) {
+    try {
+        const CaptureReader reader(fileName);
+        auto vision = std::make_shared<MyVision>();
+        QVector<qint64> frameTimesUs;
+        frameTimesUs.reserve(reader.frameCount());
+        auto mismatches = 0;
+
+        QElapsedTimer replayClock;
+        replayClock.start();
+        qint64 firstTimeNs = 0;
+        for (auto index = 0; index < reader.frameCount() && !_stopReplay; index++) {
+            const auto frame = reader.frame(index);
+            if (index == 0) {
+                firstTimeNs = frame.timeNs;
+            }
+            if (originalRate) {
+                // keep the recorded distance of the frames to the first one
+                const auto dueNs = frame.timeNs - firstTimeNs;
+                const auto waitNs = dueNs - replayClock.nsecsElapsed();
+                if (waitNs > 0) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+                }
+            }
+
+            const auto format = frame.inputs.isEmpty() || frame.inputs.first().isEmpty()
+                                    ? QImage::Format_RGB888
+                                    : frame.inputs.first().first().format();
+            vision->setCnnData(_cnnRoiHandler.activeRoiCnnList(), format);
+            QElapsedTimer frameClock;
+            frameClock.start();
+            if (!vision->replay(frame.inputs)) {
+                mismatches++;
+                continue;
+            }
+            frameTimesUs.append(frameClock.nsecsElapsed() / 1000);
+        }
+        const auto replayMs = std::max<qint64>(replayClock.elapsed(), 1);
+
+        auto meanMs = 0.;
+        auto p99Ms = 0.;
+        if (!frameTimesUs.isEmpty()) {
+            for (const auto time : qAsConst(frameTimesUs)) {
+                meanMs += static_cast<double>(time) / 1000.;
+            }
+            meanMs /= frameTimesUs.size();
+            const auto p99 = frameTimesUs.begin() + (frameTimesUs.size() * 99) / 100;
+            std::nth_element(frameTimesUs.begin(), p99, frameTimesUs.end());
+            p99Ms = static_cast<double>(*p99) / 1000.;
+        }
+        const auto fps = frameTimesUs.size() * 1000. / replayMs;
+
+        // the scaling always runs at maximum rate, it measures the throughput
+        QStringList scaling;
+        if (!frameTimesUs.isEmpty()) {
+            const auto fpsByShards = measureShardScaling(reader, _cnnRoiHandler.activeRoiCnnList(), _stopReplay);
+            for (auto shards = 1; shards <= fpsByShards.size(); shards++) {
+                scaling.append(QStringLiteral("%1: %2 fps (%3x)")
+                                   .arg(shards)
+                                   .arg(fpsByShards.at(shards - 1), 0, 'f', 1)
+                                   .arg(fpsByShards.at(shards - 1) / std::max(fpsByShards.first(), 0.001), 0, 'f', 2));
+            }
+        }
+
+        setReport(QStringLiteral("Replay: %1 frames, %2 not matching the configuration\n\r"
+                                 "%3 fps, mean %4 ms, p99 %5 ms per frame\n\r"
+                                 "Shards %6")
+                      .arg(frameTimesUs.size())
+                      .arg(mismatches)
+                      .arg(fps, 0, 'f', 1)
+                      .arg(meanMs, 0, 'f', 2)
+                      .arg(p99Ms, 0, 'f', 2)
+                      .arg(scaling.join(QStringLiteral(", "))),
+                  QStringLiteral("Wiedergabe: %1 Bilder, %2 passen nicht zur Konfiguration\n\r"
+                                 "%3 fps, Mittel %4 ms, p99 %5 ms pro Bild\n\r"
+                                 "Shards %6")
+                      .arg(frameTimesUs.size())
+                      .arg(mismatches)
+                      .arg(fps, 0, 'f', 1)
+                      .arg(meanMs, 0, 'f', 2)
+                      .arg(p99Ms, 0, 'f', 2)
+                      .arg(scaling.join(QStringLiteral(", "))));
+    } catch (const std::exception& e) {
+        qCCritical(lc) << "Replay failed:" << e.what();
+        setReport(QStringLiteral("Replay failed:\n\r%1").arg(e.what()),
+                  QStringLiteral("Wiedergabe fehlgeschlagen:\n\r%1").arg(e.what()));
+    }
+}
+
+void Capture::setReport(const QString& reportEN, const QString& reportDE) {
+    // the description belongs to the main thread
+    QMetaObject::invokeMethod(
+        this,
+        [this, reportEN, reportDE]() {
+            QMap<QString, QString> translations;
+            translations.insert(QStringLiteral("en"), reportEN);
+            translations.insert(QStringLiteral("de"), reportDE);
+            _captureFile.setDescription(IDS::NXT::TranslatedText(translations));
+        },
+        Qt::QueuedConnection);
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <configurablebool.h>
+#include <configurablefile.h>
+
+#include "rcupointer.h"
+
+class CnnRoiHandler;
+
+/**
+ * @brief Writes the cut out ROIs of the processed images into a memory-mapped capture file
+ *
+ * The file is allocated with its full capacity and mapped when the recording starts. Every frame reserves its
+ * space with one atomic addition and is copied into the mapping afterwards, so vision objects record in parallel
+ * without a lock. The recording stops when the file is full. The file is finalized when the last vision object
+ * released the writer.
+ */
+class CaptureWriter {
+public:
+    /**
+     * @brief C'tor
+     * @param fileName Capture file
+     * @param capacity Maximum size of the file in bytes
+     * @throw std::runtime_error if the file can not be created or mapped
+     */
+    CaptureWriter(const QString& fileName, qint64 capacity);
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    /**
+     * @brief Records the CNN inputs of an image
+     * @param inputs Cut out ROIs, one list of input buffers per ROI
+     * @return False if the file is full
+     */
+    bool recordFrame(const QVector<QVector<QImage>>& inputs);
+
+private:
+    QFile _file;
+    uchar* _data = nullptr;
+    qint64 _capacity = 0;
+    std::atomic<qint64> _used{0};
+    QElapsedTimer _clock;
+};
+
+/**
+ * @brief Reads a capture file
+ *
+ * The file is mapped, the images of a frame refer to the mapping and are not copied.
+ */
+class CaptureReader {
+public:
+    /**
+     * @brief Recorded image
+     */
+    struct Frame {
+        qint64 timeNs = 0; // time since the start of the recording
+        QVector<QVector<QImage>> inputs; // cut out ROIs, one list of input buffers per ROI
+    };
+
+    /**
+     * @brief C'tor
+     * @param fileName Capture file
+     * @throw std::runtime_error if the file can not be mapped or is no capture file
+     */
+    explicit CaptureReader(const QString& fileName);
+
+    /**
+     * @brief Getter for the number of recorded images
+     * @return Number of frames
+     */
+    int frameCount() const;
+
+    /**
+     * @brief Getter for a recorded image
+     * @param index Index of the frame in recording order
+     * @return Frame, it is valid as long as the reader exists
+     */
+    Frame frame(int index) const;
+
+private:
+    QFile _file;
+    const uchar* _data = nullptr;
+    qint64 _size = 0;
+    QVector<qint64> _frameOffsets;
+};
+
+/**
+ * @brief Record and replay of the CNN inputs
+ *
+ * While recording is switched on, the cut out ROIs of every image are written to the capture file. Switching on
+ * replay feeds the capture file through the CNNs of the active configuration, at the recorded or at maximum rate.
+ * The throughput of the replay is shown in the description of the capture file.
+ */
+class Capture : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief C'tor
+     * @param cnnRoiHandler The handler of the ROI/CNN configuration
+     */
+    explicit Capture(CnnRoiHandler& cnnRoiHandler);
+    ~Capture() override;
+
+    /**
+     * @brief Getter for the active recording
+     * @return Writer of the capture file, nullptr if recording is switched off
+     */
+    std::shared_ptr<CaptureWriter> writer() const;
+
+private slots:
+    /**
+     * @brief Setter for the recording status
+     * @param enable Flag to start/stop the recording
+     */
+    void enableRecording(bool enable);
+
+    /**
+     * @brief Setter for the replay status
+     * @param enable Flag to start/stop the replay
+     */
+    void enableReplay(bool enable);
+
+private:
+    void stopReplay();
+    void replay(const QString& fileName, bool originalRate);
+    void setReport(const QString& reportEN, const QString& reportDE);
+
+    CnnRoiHandler& _cnnRoiHandler;
+    IDS::NXT::ConfigurableBool _recording;
+    IDS::NXT::ConfigurableBool _replay;
+    IDS::NXT::ConfigurableFile _captureFile;
+    RcuPointer<CaptureWriter> _writer{nullptr};
+    std::thread _replayThread;
+    std::atomic_bool _stopReplay{false};
+};
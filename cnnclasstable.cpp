@@ -0,0 +1,117 @@
+#include "cnnclasstable.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSet>
+
+#include "myresultimage.h"
+
+static constexpr int MAX_RESULT_VALUES = 5;
+
+/**
+ * @brief Returns a shared instance of the given string
+ *
+ * Class names like "OK" or "NOK" are used by many CNNs. Interning lets all class tables share the same string data.
+ * Class tables are only built in the main thread, so no locking is needed.
+ */
+static QString intern(const QString& text) {
+    static QSet<QString> pool;
+
+    const auto iter = pool.constFind(text);
+    if (iter != pool.constEnd()) {
+        return *iter;
+    }
+    pool.insert(text);
+
+    return text;
+}
+
+CnnClassTable::CnnClassTable(const QStringList& classes) {
+    _names.reserve(classes.size());
+    _jsonNames.reserve(classes.size());
+    _jsonFragments.reserve(classes.size());
+    _labelWidths.reserve(classes.size());
+
+    for (const auto& cls : classes) {
+        const auto name = intern(cls);
+        _names.append(name);
+        _jsonNames.append(jsonString(name));
+        _jsonFragments.append("{\"Class\":" + _jsonNames.last() + ",\"Probability\":");
+        _labelWidths.append(MyResultImage::labelWidth(name));
+    }
+}
+
+int CnnClassTable::size() const {
+    return _names.size();
+}
+
+const QStringList& CnnClassTable::names() const {
+    return _names;
+}
+
+const QString& CnnClassTable::name(int index) const {
+    return _names.at(index);
+}
+
+const QByteArray& CnnClassTable::jsonName(int index) const {
+    return _jsonNames.at(index);
+}
+
+const QByteArray& CnnClassTable::jsonFragment(int index) const {
+    return _jsonFragments.at(index);
+}
+
+int CnnClassTable::labelWidth(int index) const {
+    return _labelWidths.at(index);
+}
+
+/**
+ * @brief Appends a probability rounded to two decimals in the notation of QJsonDocument
+ *
+ * Halves are rounded up by qRound(), e.g. 0.125 gives 0.13. QString::number(probability, 'f', 2) of the former
+ * serialization rounds the exact binary value instead, so both can differ in the last digit at such halves. Apart
+ * from that the notation is the same, without the detour over strings and doubles.
+ */
+static void appendProbability(QByteArray& output, double probability) {
+    const auto hundredths = qRound(probability * 100);
+    if (hundredths >= 100) {
+        output.append('1');
+    } else if (hundredths <= 0) {
+        output.append('0');
+    } else {
+        output.append("0.");
+        output.append(static_cast<char>('0' + hundredths / 10));
+        if (hundredths % 10 != 0) {
+            output.append(static_cast<char>('0' + hundredths % 10));
+        }
+    }
+}
+
+void CnnClassTable::appendJson(QByteArray& output,
+                               const QVector<QPair<int, double>>& results,
+                               double expsum,
+                               bool limitResults) const {
+    output.append('[');
+
+    auto resultCnt = 0;
+    for (const auto& result : results) {
+        if (resultCnt++ > 0) {
+            output.append(',');
+        }
+        output.append(_jsonFragments.at(result.first));
+        appendProbability(output, result.second / expsum);
+        output.append('}');
+
+        if (limitResults && resultCnt > MAX_RESULT_VALUES) {
+            break;
+        }
+    }
+
+    output.append(']');
+}
+
+QByteArray CnnClassTable::jsonString(const QString& text) {
+    // Let QJsonDocument do the escaping and strip the surrounding brackets
+    const auto array = QJsonDocument(QJsonArray{text}).toJson(QJsonDocument::Compact);
+    return array.mid(1, array.size() - 2);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QByteArray>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Precomputed class table of one CNN
+ *
+ * The table is built once when a CNN gets activated. It holds the interned class names, the UTF-8 encoded
+ * JSON fragment of every class and the label width of every class name at the initial overlay font size.
+ * The frame path only handles class indices and looks up everything else here.
+ */
+class CnnClassTable {
+public:
+    /**
+     * @brief C'tor
+     * @param classes Class names of the CNN
+     */
+    explicit CnnClassTable(const QStringList& classes);
+
+    /**
+     * @brief Getter for the number of classes
+     * @return Number of classes
+     */
+    int size() const;
+
+    /**
+     * @brief Getter for all class names
+     * @return Class names in output order of the CNN
+     */
+    const QStringList& names() const;
+
+    /**
+     * @brief Getter for the name of one class
+     * @param index Class index
+     * @return Class name
+     */
+    const QString& name(int index) const;
+
+    /**
+     * @brief Getter for the JSON fragment of one class
+     * @param index Class index
+     * @return UTF-8 encoded fragment <tt>{"Class":"<name>","Probability":</tt>
+     */
+    const QByteArray& jsonFragment(int index) const;
+
+    /**
+     * @brief Getter for the JSON string of one class name
+     * @param index Class index
+     * @return UTF-8 encoded and escaped class name including the quotes
+     */
+    const QByteArray& jsonName(int index) const;
+
+    /**
+     * @brief Getter for the label width of one class
+     * @param index Class index
+     * @return Width of the class name in px at the initial overlay font size
+     */
+    int labelWidth(int index) const;
+
+    /**
+     * @brief Appends the classification result as JSON array
+     * @param output Buffer the array is appended to
+     * @param results Pairs of class index and unnormalized probability, sorted by probability
+     * @param expsum Softmax divisor
+     * @param limitResults Flag to limit the number of listed classes
+     */
+    void appendJson(QByteArray& output,
+                    const QVector<QPair<int, double>>& results,
+                    double expsum,
+                    bool limitResults = false) const;
+
+    /**
+     * @brief Encodes a string as JSON string literal
+     * @param text String to encode
+     * @return UTF-8 encoded and escaped string including the quotes
+     */
+    static QByteArray jsonString(const QString& text);
+
+private:
+    QStringList _names;
+    QVector<QByteArray> _jsonNames;
+    QVector<QByteArray> _jsonFragments;
+    QVector<int> _labelWidths;
+};
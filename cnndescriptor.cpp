@@ -0,0 +1,39 @@
+#include "cnndescriptor.h"
+
+#include <stdexcept>
+
+using namespace IDS::NXT::CNNv2;
+
+CnnDescriptor::CnnDescriptor(const CnnData& cnnData, std::shared_ptr<const CnnClassTable> classTable)
+  : _name{cnnData.name()}
+  , _inputSize{cnnData.inputSize()}
+  , _classTable{std::move(classTable)} {
+    if (cnnData.inferenceType() != CnnData::InferenceType::Classification) {
+        throw std::runtime_error("CNN " + _name.toStdString() + " is not suited for classification");
+    }
+    if (!_classTable || _classTable->size() == 0 || _inputSize.isEmpty()) {
+        throw std::runtime_error("CNN " + _name.toStdString() + " has no classes or no input size");
+    }
+    // The output buffers are checked with every result, an inference here would stall the activation
+    _kernels = &Softmax::kernels(_classTable->size());
+}
+
+const QString& CnnDescriptor::name() const {
+    return _name;
+}
+
+QSize CnnDescriptor::inputSize() const {
+    return _inputSize;
+}
+
+int CnnDescriptor::classCount() const {
+    return _classTable->size();
+}
+
+const std::shared_ptr<const CnnClassTable>& CnnDescriptor::classTable() const {
+    return _classTable;
+}
+
+const Softmax::Kernels& CnnDescriptor::kernels() const {
+    return *_kernels;
+}
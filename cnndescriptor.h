@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QSize>
+#include <QString>
+
+#include <memory>
+
+#include <cnnmanager_v2.h>
+
+#include "cnnclasstable.h"
+#include "softmax.h"
+
+/**
+ * @brief Validated metadata of an activated CNN
+ *
+ * The descriptor is built once when a CNN gets activated, so the frame path reads plain fields instead of querying
+ * the CNN data. Only classification CNNs get a descriptor, other CNNs are rejected on activation. Building it does
+ * not run the CNN, the size of the output buffer is checked with every result instead.
+ */
+class CnnDescriptor {
+public:
+    /**
+     * @brief C'tor
+     * @param cnnData Activated CNN
+     * @param classTable Class table of the CNN
+     *
+     * Throws a std::runtime_error if the CNN is not suited for classification or has no classes.
+     */
+    CnnDescriptor(const IDS::NXT::CNNv2::CnnData& cnnData, std::shared_ptr<const CnnClassTable> classTable);
+
+    /**
+     * @brief Getter for the name of the CNN
+     * @return Name
+     */
+    const QString& name() const;
+
+    /**
+     * @brief Getter for the input geometry
+     * @return Input size in px
+     */
+    QSize inputSize() const;
+
+    /**
+     * @brief Getter for the number of classes
+     * @return Number of classes
+     */
+    int classCount() const;
+
+    /**
+     * @brief Getter for the class table
+     * @return Class table
+     */
+    const std::shared_ptr<const CnnClassTable>& classTable() const;
+
+    /**
+     * @brief Getter for the post-processing kernels
+     * @return Kernels selected for the class count of the CNN
+     */
+    const Softmax::Kernels& kernels() const;
+
+private:
+    QString _name;
+    QSize _inputSize;
+    std::shared_ptr<const CnnClassTable> _classTable;
+    const Softmax::Kernels* _kernels = nullptr;
+};
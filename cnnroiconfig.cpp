@@ -8,6 +8,64 @@
 #include <QRegularExpression>
 
 static constexpr auto CONFIG_MAX_ROIS = 20;
+static_assert(CONFIG_MAX_ROIS <= 32, "the OK mask has one bit per ROI");
+static constexpr auto CONFIG_MAX_VISION_POOL_SIZE = 8;
+static constexpr auto CONFIG_MAX_SHARDS = 4;
+static constexpr auto CONFIG_TAG_ROIS = "Rois";
+static constexpr auto CONFIG_TAG_SETTINGS = "Settings";
+static constexpr auto CONFIG_TAG_VISIONPOOLSIZE = "VisionPoolSize";
+static constexpr auto CONFIG_TAG_WARMUP = "WarmUp";
+static constexpr auto CONFIG_TAG_FRAMEBUDGET = "FrameBudgetMs";
+static constexpr auto CONFIG_TAG_PRIORITY = "Priority";
+static constexpr auto CONFIG_TAG_CASCADE = "Cascade";
+static constexpr auto CONFIG_TAG_THRESHOLD = "Threshold";
+static constexpr auto CONFIG_TAG_ENSEMBLE = "Ensemble";
+static constexpr auto CONFIG_TAG_FUSION = "Fusion";
+static constexpr auto CONFIG_FUSION_AVERAGE = "Average";
+static constexpr auto CONFIG_FUSION_VOTE = "Vote";
+static constexpr auto CONFIG_TAG_SMOOTHING = "Smoothing";
+static constexpr auto CONFIG_TAG_MODE = "Mode";
+static constexpr auto CONFIG_TAG_ALPHA = "Alpha";
+static constexpr auto CONFIG_TAG_N = "N";
+static constexpr auto CONFIG_TAG_M = "M";
+static constexpr auto CONFIG_SMOOTHING_EMA = "Ema";
+static constexpr auto CONFIG_SMOOTHING_HYSTERESIS = "Hysteresis";
+static constexpr auto CONFIG_TAG_PUBLISHMODE = "PublishMode";
+static constexpr auto CONFIG_TAG_HEARTBEAT = "HeartbeatMs";
+static constexpr auto CONFIG_PUBLISHMODE_ALWAYS = "Always";
+static constexpr auto CONFIG_PUBLISHMODE_ONCHANGE = "OnChange";
+static constexpr auto CONFIG_TAG_OUTPUTS = "Outputs";
+static constexpr auto CONFIG_TAG_SHARDS = "Shards";
+static constexpr auto CONFIG_TAG_SHARDBY = "ShardBy";
+static constexpr auto CONFIG_SHARDBY_CNN = "Cnn";
+static constexpr auto CONFIG_SHARDBY_KEY = "Key";
+static constexpr auto CONFIG_TAG_SHARD = "Shard";
+static constexpr auto CONFIG_TAG_METRICSINTERVAL = "MetricsIntervalMs";
+static constexpr auto CONFIG_TAG_CAPTURESIZE = "CaptureSizeMb";
+static constexpr auto CONFIG_MAX_CAPTURE_SIZE_MB = 1024;
+static constexpr auto CONFIG_TAG_REPLAYRATE = "ReplayRate";
+static constexpr auto CONFIG_REPLAYRATE_ORIGINAL = "Original";
+static constexpr auto CONFIG_REPLAYRATE_MAXIMUM = "Maximum";
+static constexpr auto CONFIG_TAG_OVERLOADLATENCY = "OverloadLatencyMs";
+static constexpr auto CONFIG_TAG_OVERLOADSUBSAMPLE = "OverloadSubsample";
+static constexpr auto CONFIG_TAG_CRITICAL = "Critical";
+static constexpr auto CONFIG_TAG_SENSORAOI = "SensorAoi";
+static constexpr auto CONFIG_SENSORAOI_FULL = "Full";
+static constexpr auto CONFIG_SENSORAOI_ROIS = "Rois";
+static constexpr auto CONFIG_TAG_EVIDENCECLASSES = "EvidenceClasses";
+static constexpr auto CONFIG_TAG_EVIDENCETHRESHOLD = "EvidenceThreshold";
+static constexpr auto CONFIG_TAG_EVIDENCEFORMAT = "EvidenceFormat";
+static constexpr auto CONFIG_EVIDENCEFORMAT_JPG = "Jpg";
+static constexpr auto CONFIG_EVIDENCEFORMAT_PNG = "Png";
+static constexpr auto CONFIG_TAG_EVIDENCESIZE = "EvidenceSizeMb";
+static constexpr auto CONFIG_MAX_EVIDENCE_SIZE_MB = 4096;
+static constexpr auto CONFIG_TAG_OK = "Ok";
+static constexpr auto CONFIG_TAG_CLASSES = "Classes";
+static constexpr auto CONFIG_TAG_VERDICT = "Verdict";
+static constexpr auto CONFIG_VERDICT_ALL = "All";
+static constexpr auto CONFIG_VERDICT_ANY = "Any";
+static constexpr auto CONFIG_VERDICT_COUNT = "Count";
+static constexpr auto CONFIG_TAG_VERDICTMINOK = "VerdictMinOk";
 static constexpr auto CONFIG_TAG_CNN = "Cnn";
 static constexpr auto CONFIG_TAG_ROINAME = "RoiName";
 static constexpr auto CONFIG_TAG_OFFSETX = "OffsetX";
@@ -47,7 +105,14 @@ void CnnRoiConfig::loadJsonFile(const QString& file) {
             throw(std::runtime_error(err.errorString().toStdString()));
         }
 
-        const auto roiConfigs = loadedJson.array();
+        // The config is either the plain list of ROIs or an object with the list and global settings
+        auto roiConfigs = loadedJson.array();
+        Settings loadedSettings;
+        if (loadedJson.isObject()) {
+            const auto config = loadedJson.object();
+            roiConfigs = config.value(CONFIG_TAG_ROIS).toArray();
+            loadedSettings.loadMap(config.value(CONFIG_TAG_SETTINGS).toObject().toVariantMap());
+        }
         qCDebug(lc) << "loaded ROI config:" << roiConfigs;
         if (roiConfigs.size() > CONFIG_MAX_ROIS) {
             const auto error = QStringLiteral("Error loading config. maximum number is %1").arg(CONFIG_MAX_ROIS);
@@ -63,8 +128,10 @@ void CnnRoiConfig::loadJsonFile(const QString& file) {
         }
 
         _cnnRois = loadedCnnRois;
+        _settings = loadedSettings;
     } catch (...) {
         _cnnRois.clear();
+        _settings = Settings{};
         _roiConfigFile.clear();
         throw;
     }
@@ -89,9 +156,13 @@ void CnnRoiConfig::saveConfig() {
         config.append(QJsonObject::fromVariantMap(map));
     }
 
+    QJsonObject configWithSettings;
+    configWithSettings.insert(CONFIG_TAG_ROIS, config);
+    configWithSettings.insert(CONFIG_TAG_SETTINGS, QJsonObject::fromVariantMap(_settings.toMap()));
+
     QFile file(_roiConfigFile);
     file.open(QIODevice::WriteOnly);
-    file.write(QJsonDocument(config).toJson());
+    file.write(QJsonDocument(configWithSettings).toJson());
     file.close();
 }
 
@@ -109,10 +180,291 @@ CnnRoiConfig::CnnRoiMap CnnRoiConfig::getCnnRoi(const QString& cnn) {
     return CnnRoiConfig::CnnRoiMap(_cnnRois[cnn].toMap());
 }
 
+CnnRoiConfig::Settings CnnRoiConfig::settings() const {
+    return _settings;
+}
+
 int CnnRoiConfig::getMaxRois() {
     return CONFIG_MAX_ROIS;
 }
 
+CnnRoiConfig::Settings::Settings(const QVariantMap& map) {
+    loadMap(map);
+}
+
+void CnnRoiConfig::Settings::loadMap(const QVariantMap& map) {
+    // All settings are optional, missing ones keep their default value
+    if (map.contains(CONFIG_TAG_VISIONPOOLSIZE)) {
+        bool ok = true;
+        const auto visionPoolSize = map.value(CONFIG_TAG_VISIONPOOLSIZE).toInt(&ok);
+        if (!ok || visionPoolSize < 0 || visionPoolSize > CONFIG_MAX_VISION_POOL_SIZE) {
+            throw std::runtime_error(std::string(CONFIG_TAG_VISIONPOOLSIZE) + " must be between 0 and "
+                                     + std::to_string(CONFIG_MAX_VISION_POOL_SIZE));
+        }
+        _visionPoolSize = visionPoolSize;
+    }
+    if (map.contains(CONFIG_TAG_WARMUP)) {
+        _warmUp = map.value(CONFIG_TAG_WARMUP).toBool();
+    }
+    if (map.contains(CONFIG_TAG_FRAMEBUDGET)) {
+        bool ok = true;
+        const auto frameBudget = map.value(CONFIG_TAG_FRAMEBUDGET).toInt(&ok);
+        if (!ok || frameBudget < 0) {
+            throw std::runtime_error(std::string(CONFIG_TAG_FRAMEBUDGET) + " must not be negative");
+        }
+        _frameBudgetMs = frameBudget;
+    }
+    if (map.contains(CONFIG_TAG_PUBLISHMODE)) {
+        const auto publishMode = map.value(CONFIG_TAG_PUBLISHMODE).toString();
+        if (publishMode != CONFIG_PUBLISHMODE_ALWAYS && publishMode != CONFIG_PUBLISHMODE_ONCHANGE) {
+            throw std::runtime_error(std::string(CONFIG_TAG_PUBLISHMODE) + " must be " + CONFIG_PUBLISHMODE_ALWAYS
+                                     + " or " + CONFIG_PUBLISHMODE_ONCHANGE);
+        }
+        _publishOnChange = publishMode == CONFIG_PUBLISHMODE_ONCHANGE;
+    }
+    if (map.contains(CONFIG_TAG_HEARTBEAT)) {
+        bool ok = true;
+        const auto heartbeat = map.value(CONFIG_TAG_HEARTBEAT).toInt(&ok);
+        if (!ok || heartbeat < 0) {
+            throw std::runtime_error(std::string(CONFIG_TAG_HEARTBEAT) + " must not be negative");
+        }
+        _heartbeatMs = heartbeat;
+    }
+    if (map.contains(CONFIG_TAG_SHARDS)) {
+        bool ok = true;
+        const auto shards = map.value(CONFIG_TAG_SHARDS).toInt(&ok);
+        if (!ok || shards < 1 || shards > CONFIG_MAX_SHARDS) {
+            throw std::runtime_error(std::string(CONFIG_TAG_SHARDS) + " must be between 1 and "
+                                     + std::to_string(CONFIG_MAX_SHARDS));
+        }
+        _shards = shards;
+    }
+    if (map.contains(CONFIG_TAG_SHARDBY)) {
+        const auto shardBy = map.value(CONFIG_TAG_SHARDBY).toString();
+        if (shardBy != CONFIG_SHARDBY_CNN && shardBy != CONFIG_SHARDBY_KEY) {
+            throw std::runtime_error(std::string(CONFIG_TAG_SHARDBY) + " must be " + CONFIG_SHARDBY_CNN + " or "
+                                     + CONFIG_SHARDBY_KEY);
+        }
+        _shardByKey = shardBy == CONFIG_SHARDBY_KEY;
+    }
+    if (map.contains(CONFIG_TAG_METRICSINTERVAL)) {
+        bool ok = true;
+        const auto metricsInterval = map.value(CONFIG_TAG_METRICSINTERVAL).toInt(&ok);
+        if (!ok || metricsInterval < 0) {
+            throw std::runtime_error(std::string(CONFIG_TAG_METRICSINTERVAL) + " must not be negative");
+        }
+        _metricsIntervalMs = metricsInterval;
+    }
+    if (map.contains(CONFIG_TAG_CAPTURESIZE)) {
+        bool ok = true;
+        const auto captureSize = map.value(CONFIG_TAG_CAPTURESIZE).toInt(&ok);
+        if (!ok || captureSize < 1 || captureSize > CONFIG_MAX_CAPTURE_SIZE_MB) {
+            throw std::runtime_error(std::string(CONFIG_TAG_CAPTURESIZE) + " must be between 1 and "
+                                     + std::to_string(CONFIG_MAX_CAPTURE_SIZE_MB));
+        }
+        _captureSizeMb = captureSize;
+    }
+    if (map.contains(CONFIG_TAG_REPLAYRATE)) {
+        const auto replayRate = map.value(CONFIG_TAG_REPLAYRATE).toString();
+        if (replayRate != CONFIG_REPLAYRATE_ORIGINAL && replayRate != CONFIG_REPLAYRATE_MAXIMUM) {
+            throw std::runtime_error(std::string(CONFIG_TAG_REPLAYRATE) + " must be " + CONFIG_REPLAYRATE_ORIGINAL
+                                     + " or " + CONFIG_REPLAYRATE_MAXIMUM);
+        }
+        _replayOriginalRate = replayRate == CONFIG_REPLAYRATE_ORIGINAL;
+    }
+    if (map.contains(CONFIG_TAG_OVERLOADLATENCY)) {
+        bool ok = true;
+        const auto overloadLatency = map.value(CONFIG_TAG_OVERLOADLATENCY).toInt(&ok);
+        if (!ok || overloadLatency < 0) {
+            throw std::runtime_error(std::string(CONFIG_TAG_OVERLOADLATENCY) + " must not be negative");
+        }
+        _overloadLatencyMs = overloadLatency;
+    }
+    if (map.contains(CONFIG_TAG_OVERLOADSUBSAMPLE)) {
+        bool ok = true;
+        const auto overloadSubsample = map.value(CONFIG_TAG_OVERLOADSUBSAMPLE).toInt(&ok);
+        if (!ok || overloadSubsample < 1) {
+            throw std::runtime_error(std::string(CONFIG_TAG_OVERLOADSUBSAMPLE) + " must be at least 1");
+        }
+        _overloadSubsample = overloadSubsample;
+    }
+    if (map.contains(CONFIG_TAG_SENSORAOI)) {
+        const auto sensorAoi = map.value(CONFIG_TAG_SENSORAOI).toString();
+        if (sensorAoi != CONFIG_SENSORAOI_FULL && sensorAoi != CONFIG_SENSORAOI_ROIS) {
+            throw std::runtime_error(std::string(CONFIG_TAG_SENSORAOI) + " must be " + CONFIG_SENSORAOI_FULL + " or "
+                                     + CONFIG_SENSORAOI_ROIS);
+        }
+        _sensorAoiFromRois = sensorAoi == CONFIG_SENSORAOI_ROIS;
+    }
+    if (map.contains(CONFIG_TAG_EVIDENCECLASSES)) {
+        _evidenceClasses = map.value(CONFIG_TAG_EVIDENCECLASSES).toStringList();
+    }
+    if (map.contains(CONFIG_TAG_EVIDENCETHRESHOLD)) {
+        bool ok = true;
+        const auto evidenceThreshold = map.value(CONFIG_TAG_EVIDENCETHRESHOLD).toDouble(&ok);
+        if (!ok || evidenceThreshold < 0. || evidenceThreshold > 1.) {
+            throw std::runtime_error(std::string(CONFIG_TAG_EVIDENCETHRESHOLD) + " must be between 0 and 1");
+        }
+        _evidenceThreshold = evidenceThreshold;
+    }
+    if (map.contains(CONFIG_TAG_EVIDENCEFORMAT)) {
+        const auto evidenceFormat = map.value(CONFIG_TAG_EVIDENCEFORMAT).toString();
+        if (evidenceFormat != CONFIG_EVIDENCEFORMAT_JPG && evidenceFormat != CONFIG_EVIDENCEFORMAT_PNG) {
+            throw std::runtime_error(std::string(CONFIG_TAG_EVIDENCEFORMAT) + " must be " + CONFIG_EVIDENCEFORMAT_JPG
+                                     + " or " + CONFIG_EVIDENCEFORMAT_PNG);
+        }
+        _evidencePng = evidenceFormat == CONFIG_EVIDENCEFORMAT_PNG;
+    }
+    if (map.contains(CONFIG_TAG_EVIDENCESIZE)) {
+        bool ok = true;
+        const auto evidenceSize = map.value(CONFIG_TAG_EVIDENCESIZE).toInt(&ok);
+        if (!ok || evidenceSize < 1 || evidenceSize > CONFIG_MAX_EVIDENCE_SIZE_MB) {
+            throw std::runtime_error(std::string(CONFIG_TAG_EVIDENCESIZE) + " must be between 1 and "
+                                     + std::to_string(CONFIG_MAX_EVIDENCE_SIZE_MB));
+        }
+        _evidenceSizeMb = evidenceSize;
+    }
+    if (map.contains(CONFIG_TAG_VERDICT)) {
+        const auto verdict = map.value(CONFIG_TAG_VERDICT).toString();
+        if (verdict == CONFIG_VERDICT_ALL) {
+            _verdict = Verdict::All;
+        } else if (verdict == CONFIG_VERDICT_ANY) {
+            _verdict = Verdict::Any;
+        } else if (verdict == CONFIG_VERDICT_COUNT) {
+            _verdict = Verdict::Count;
+        } else {
+            throw std::runtime_error(std::string(CONFIG_TAG_VERDICT) + " must be " + CONFIG_VERDICT_ALL + ", "
+                                     + CONFIG_VERDICT_ANY + " or " + CONFIG_VERDICT_COUNT);
+        }
+    }
+    if (map.contains(CONFIG_TAG_VERDICTMINOK)) {
+        bool ok = true;
+        const auto verdictMinOk = map.value(CONFIG_TAG_VERDICTMINOK).toInt(&ok);
+        if (!ok || verdictMinOk < 1) {
+            throw std::runtime_error(std::string(CONFIG_TAG_VERDICTMINOK) + " must be at least 1");
+        }
+        _verdictMinOk = verdictMinOk;
+    }
+    const auto outputs = map.value(CONFIG_TAG_OUTPUTS).toMap();
+    for (auto iter = outputs.begin(); iter != outputs.end(); ++iter) {
+        _outputFormats[iter.key()] = OutputFormat(iter.value().toMap());
+    }
+}
+
+QVariantMap CnnRoiConfig::Settings::toMap() const {
+    QVariantMap settings;
+    settings[CONFIG_TAG_VISIONPOOLSIZE] = _visionPoolSize;
+    settings[CONFIG_TAG_WARMUP] = _warmUp;
+    settings[CONFIG_TAG_FRAMEBUDGET] = _frameBudgetMs;
+    settings[CONFIG_TAG_PUBLISHMODE] = _publishOnChange ? CONFIG_PUBLISHMODE_ONCHANGE : CONFIG_PUBLISHMODE_ALWAYS;
+    settings[CONFIG_TAG_HEARTBEAT] = _heartbeatMs;
+    settings[CONFIG_TAG_SHARDS] = _shards;
+    settings[CONFIG_TAG_SHARDBY] = _shardByKey ? CONFIG_SHARDBY_KEY : CONFIG_SHARDBY_CNN;
+    settings[CONFIG_TAG_METRICSINTERVAL] = _metricsIntervalMs;
+    settings[CONFIG_TAG_CAPTURESIZE] = _captureSizeMb;
+    settings[CONFIG_TAG_REPLAYRATE] = _replayOriginalRate ? CONFIG_REPLAYRATE_ORIGINAL : CONFIG_REPLAYRATE_MAXIMUM;
+    settings[CONFIG_TAG_OVERLOADLATENCY] = _overloadLatencyMs;
+    settings[CONFIG_TAG_OVERLOADSUBSAMPLE] = _overloadSubsample;
+    settings[CONFIG_TAG_SENSORAOI] = _sensorAoiFromRois ? CONFIG_SENSORAOI_ROIS : CONFIG_SENSORAOI_FULL;
+    settings[CONFIG_TAG_EVIDENCECLASSES] = _evidenceClasses;
+    settings[CONFIG_TAG_EVIDENCETHRESHOLD] = _evidenceThreshold;
+    settings[CONFIG_TAG_EVIDENCEFORMAT] = _evidencePng ? CONFIG_EVIDENCEFORMAT_PNG : CONFIG_EVIDENCEFORMAT_JPG;
+    settings[CONFIG_TAG_EVIDENCESIZE] = _evidenceSizeMb;
+    settings[CONFIG_TAG_VERDICT] = _verdict == Verdict::Any     ? CONFIG_VERDICT_ANY
+                                   : _verdict == Verdict::Count ? CONFIG_VERDICT_COUNT
+                                                                : CONFIG_VERDICT_ALL;
+    settings[CONFIG_TAG_VERDICTMINOK] = _verdictMinOk;
+    if (!_outputFormats.isEmpty()) {
+        QVariantMap outputs;
+        for (auto iter = _outputFormats.begin(); iter != _outputFormats.end(); ++iter) {
+            outputs[iter.key()] = iter.value().toMap();
+        }
+        settings[CONFIG_TAG_OUTPUTS] = outputs;
+    }
+
+    return settings;
+}
+
+int CnnRoiConfig::Settings::visionPoolSize() const {
+    return _visionPoolSize;
+}
+
+bool CnnRoiConfig::Settings::warmUp() const {
+    return _warmUp;
+}
+
+int CnnRoiConfig::Settings::frameBudgetMs() const {
+    return _frameBudgetMs;
+}
+
+bool CnnRoiConfig::Settings::publishOnChange() const {
+    return _publishOnChange;
+}
+
+int CnnRoiConfig::Settings::heartbeatMs() const {
+    return _heartbeatMs;
+}
+
+int CnnRoiConfig::Settings::shards() const {
+    return _shards;
+}
+
+bool CnnRoiConfig::Settings::shardByKey() const {
+    return _shardByKey;
+}
+
+int CnnRoiConfig::Settings::metricsIntervalMs() const {
+    return _metricsIntervalMs;
+}
+
+int CnnRoiConfig::Settings::captureSizeMb() const {
+    return _captureSizeMb;
+}
+
+bool CnnRoiConfig::Settings::replayOriginalRate() const {
+    return _replayOriginalRate;
+}
+
+int CnnRoiConfig::Settings::overloadLatencyMs() const {
+    return _overloadLatencyMs;
+}
+
+int CnnRoiConfig::Settings::overloadSubsample() const {
+    return _overloadSubsample;
+}
+
+bool CnnRoiConfig::Settings::sensorAoiFromRois() const {
+    return _sensorAoiFromRois;
+}
+
+QStringList CnnRoiConfig::Settings::evidenceClasses() const {
+    return _evidenceClasses;
+}
+
+double CnnRoiConfig::Settings::evidenceThreshold() const {
+    return _evidenceThreshold;
+}
+
+bool CnnRoiConfig::Settings::evidencePng() const {
+    return _evidencePng;
+}
+
+int CnnRoiConfig::Settings::evidenceSizeMb() const {
+    return _evidenceSizeMb;
+}
+
+CnnRoiConfig::Settings::Verdict CnnRoiConfig::Settings::verdict() const {
+    return _verdict;
+}
+
+int CnnRoiConfig::Settings::verdictMinOk() const {
+    return _verdictMinOk;
+}
+
+OutputFormat CnnRoiConfig::Settings::outputFormat(const QString& cnn) const {
+    return _outputFormats.value(cnn);
+}
+
 CnnRoiConfig::CnnRoiMap::CnnRoiMap(const QString& roiName, const QString& cnn, QRect rect)
   : _roiName{roiName}
   , _roiRect{rect}
@@ -160,7 +512,94 @@ void CnnRoiConfig::CnnRoiMap::loadMap(const QVariantMap& map) {
     for (const auto& param : QStringList{CONFIG_TAG_OFFSETX, CONFIG_TAG_OFFSETY, CONFIG_TAG_WIDTH, CONFIG_TAG_HEIGHT}) {
         checkRoiParameter(param);
     }
+    // the priority is optional
+    auto priority = 0;
+    if (map.contains(CONFIG_TAG_PRIORITY)) {
+        bool ok = true;
+        priority = map[CONFIG_TAG_PRIORITY].toInt(&ok);
+        if (!ok) {
+            throw std::runtime_error("Priority not valid");
+        }
+    }
+
+    // the cascade is optional
+    QList<CascadeStage> cascade;
+    for (const auto& stageValue : map.value(CONFIG_TAG_CASCADE).toList()) {
+        const auto stageMap = stageValue.toMap();
+        CascadeStage stage;
+        bool ok = true;
+        stage.cnn = stageMap.value(CONFIG_TAG_CNN).toString();
+        stage.threshold = stageMap.value(CONFIG_TAG_THRESHOLD).toDouble(&ok);
+        if (stage.cnn.isEmpty() || !ok || stage.threshold < 0. || stage.threshold > 1.) {
+            throw std::runtime_error("Cascade of \'" + name.toStdString()
+                                     + "\' not valid. Every stage needs a Cnn and a Threshold between 0 and 1");
+        }
+        cascade.append(stage);
+    }
+
+    // the ensemble is optional
+    const auto ensemble = map.value(CONFIG_TAG_ENSEMBLE).toStringList();
+    auto fusion = Fusion::Average;
+    if (map.contains(CONFIG_TAG_FUSION)) {
+        const auto fusionName = map.value(CONFIG_TAG_FUSION).toString();
+        if (fusionName == CONFIG_FUSION_VOTE) {
+            fusion = Fusion::Vote;
+        } else if (fusionName != CONFIG_FUSION_AVERAGE) {
+            throw std::runtime_error("Fusion of \'" + name.toStdString() + "\' must be " + CONFIG_FUSION_AVERAGE
+                                     + " or " + CONFIG_FUSION_VOTE);
+        }
+    }
+
+    // the smoothing is optional
+    Smoothing smoothing;
+    if (map.contains(CONFIG_TAG_SMOOTHING)) {
+        const auto smoothingMap = map.value(CONFIG_TAG_SMOOTHING).toMap();
+        const auto mode = smoothingMap.value(CONFIG_TAG_MODE).toString();
+        bool ok = true;
+        if (mode == CONFIG_SMOOTHING_EMA) {
+            smoothing.mode = Smoothing::Mode::Ema;
+            smoothing.alpha = smoothingMap.value(CONFIG_TAG_ALPHA).toDouble(&ok);
+            ok = ok && smoothing.alpha > 0. && smoothing.alpha <= 1.;
+        } else if (mode == CONFIG_SMOOTHING_HYSTERESIS) {
+            bool okM = true;
+            smoothing.mode = Smoothing::Mode::Hysteresis;
+            smoothing.n = smoothingMap.value(CONFIG_TAG_N).toInt(&ok);
+            smoothing.m = smoothingMap.value(CONFIG_TAG_M).toInt(&okM);
+            ok = ok && okM && smoothing.n > 0 && smoothing.n <= smoothing.m;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            throw std::runtime_error("Smoothing of \'" + name.toStdString() + "\' not valid. Use Mode "
+                                     + CONFIG_SMOOTHING_EMA + " with an Alpha in (0, 1] or Mode "
+                                     + CONFIG_SMOOTHING_HYSTERESIS + " with 0 < N <= M");
+        }
+    }
+
+    // the OK rule is optional
+    OkRule okRule;
+    if (map.contains(CONFIG_TAG_OK)) {
+        const auto okMap = map.value(CONFIG_TAG_OK).toMap();
+        bool ok = true;
+        okRule.classes = okMap.value(CONFIG_TAG_CLASSES).toStringList();
+        if (okMap.contains(CONFIG_TAG_THRESHOLD)) {
+            okRule.threshold = okMap.value(CONFIG_TAG_THRESHOLD).toDouble(&ok);
+        }
+        if (okRule.classes.isEmpty() || !ok || okRule.threshold < 0. || okRule.threshold > 1.) {
+            throw std::runtime_error("Ok of '" + name.toStdString()
+                                     + "' not valid. It needs Classes and a Threshold between 0 and 1");
+        }
+    }
+
     _roiName = name;
+    _priority = priority;
+    _shard = map.value(CONFIG_TAG_SHARD).toString();
+    _critical = map.value(CONFIG_TAG_CRITICAL).toBool();
+    _cascade = cascade;
+    _ensemble = ensemble;
+    _fusion = fusion;
+    _smoothing = smoothing;
+    _okRule = okRule;
     _cnn = map.value(CONFIG_TAG_CNN).toString();
     _roiRect = QRect(map[CONFIG_TAG_OFFSETX].toInt(),
                      map[CONFIG_TAG_OFFSETY].toInt(),
@@ -176,6 +615,45 @@ QVariantMap CnnRoiConfig::CnnRoiMap::toMap() const {
     thisCnn[CONFIG_TAG_OFFSETY] = _roiRect.y();
     thisCnn[CONFIG_TAG_HEIGHT] = _roiRect.height();
     thisCnn[CONFIG_TAG_WIDTH] = _roiRect.width();
+    thisCnn[CONFIG_TAG_PRIORITY] = _priority;
+    if (!_shard.isEmpty()) {
+        thisCnn[CONFIG_TAG_SHARD] = _shard;
+    }
+    if (_critical) {
+        thisCnn[CONFIG_TAG_CRITICAL] = _critical;
+    }
+    if (!_cascade.isEmpty()) {
+        QVariantList cascade;
+        for (const auto& stage : _cascade) {
+            QVariantMap stageMap;
+            stageMap[CONFIG_TAG_CNN] = stage.cnn;
+            stageMap[CONFIG_TAG_THRESHOLD] = stage.threshold;
+            cascade.append(stageMap);
+        }
+        thisCnn[CONFIG_TAG_CASCADE] = cascade;
+    }
+    if (!_ensemble.isEmpty()) {
+        thisCnn[CONFIG_TAG_ENSEMBLE] = _ensemble;
+        thisCnn[CONFIG_TAG_FUSION] = _fusion == Fusion::Vote ? CONFIG_FUSION_VOTE : CONFIG_FUSION_AVERAGE;
+    }
+    if (_smoothing.mode == Smoothing::Mode::Ema) {
+        QVariantMap smoothing;
+        smoothing[CONFIG_TAG_MODE] = CONFIG_SMOOTHING_EMA;
+        smoothing[CONFIG_TAG_ALPHA] = _smoothing.alpha;
+        thisCnn[CONFIG_TAG_SMOOTHING] = smoothing;
+    } else if (_smoothing.mode == Smoothing::Mode::Hysteresis) {
+        QVariantMap smoothing;
+        smoothing[CONFIG_TAG_MODE] = CONFIG_SMOOTHING_HYSTERESIS;
+        smoothing[CONFIG_TAG_N] = _smoothing.n;
+        smoothing[CONFIG_TAG_M] = _smoothing.m;
+        thisCnn[CONFIG_TAG_SMOOTHING] = smoothing;
+    }
+    if (!_okRule.classes.isEmpty()) {
+        QVariantMap okRule;
+        okRule[CONFIG_TAG_CLASSES] = _okRule.classes;
+        okRule[CONFIG_TAG_THRESHOLD] = _okRule.threshold;
+        thisCnn[CONFIG_TAG_OK] = okRule;
+    }
 
     return thisCnn;
 }
@@ -192,6 +670,35 @@ void CnnRoiConfig::CnnRoiMap::setRoiName(const QString& roiName) {
     _roiName = roiName;
 }
 
+void CnnRoiConfig::CnnRoiMap::setPriority(int priority) {
+    _priority = priority;
+}
+
+void CnnRoiConfig::CnnRoiMap::setShard(const QString& shard) {
+    _shard = shard;
+}
+
+void CnnRoiConfig::CnnRoiMap::setCritical(bool critical) {
+    _critical = critical;
+}
+
+void CnnRoiConfig::CnnRoiMap::setCascade(const QList<CascadeStage>& cascade) {
+    _cascade = cascade;
+}
+
+void CnnRoiConfig::CnnRoiMap::setEnsemble(const QStringList& ensemble, Fusion fusion) {
+    _ensemble = ensemble;
+    _fusion = fusion;
+}
+
+void CnnRoiConfig::CnnRoiMap::setSmoothing(const Smoothing& smoothing) {
+    _smoothing = smoothing;
+}
+
+void CnnRoiConfig::CnnRoiMap::setOkRule(const OkRule& okRule) {
+    _okRule = okRule;
+}
+
 QString CnnRoiConfig::CnnRoiMap::cnn() const {
     return _cnn;
 }
@@ -203,3 +710,46 @@ QRect CnnRoiConfig::CnnRoiMap::roiRect() const {
 QString CnnRoiConfig::CnnRoiMap::roiName() const {
     return _roiName;
 }
+
+int CnnRoiConfig::CnnRoiMap::priority() const {
+    return _priority;
+}
+
+QString CnnRoiConfig::CnnRoiMap::shard() const {
+    return _shard;
+}
+
+bool CnnRoiConfig::CnnRoiMap::critical() const {
+    return _critical;
+}
+
+QList<CnnRoiConfig::CnnRoiMap::CascadeStage> CnnRoiConfig::CnnRoiMap::cascade() const {
+    return _cascade;
+}
+
+QStringList CnnRoiConfig::CnnRoiMap::ensemble() const {
+    return _ensemble;
+}
+
+CnnRoiConfig::CnnRoiMap::Fusion CnnRoiConfig::CnnRoiMap::fusion() const {
+    return _fusion;
+}
+
+CnnRoiConfig::CnnRoiMap::OkRule CnnRoiConfig::CnnRoiMap::okRule() const {
+    return _okRule;
+}
+
+CnnRoiConfig::CnnRoiMap::Smoothing CnnRoiConfig::CnnRoiMap::smoothing() const {
+    return _smoothing;
+}
+
+QStringList CnnRoiConfig::CnnRoiMap::cnns() const {
+    QStringList cnns;
+    for (const auto& stage : _cascade) {
+        cnns.append(stage.cnn);
+    }
+    cnns.append(_cnn);
+    cnns.append(_ensemble);
+
+    return cnns;
+}
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <QMap>
 #include <QRect>
+#include <QStringList>
 #include <QVariantMap>
 
+#include "outputformat.h"
+
 /**
  * @brief This class handles the mapping between rois and cnns
  */
@@ -10,6 +14,45 @@ class CnnRoiConfig {
 public:
     class CnnRoiMap {
     public:
+        /**
+         * @brief Stage of an early-exit cascade
+         */
+        struct CascadeStage {
+            QString cnn;
+            double threshold = 1.;
+        };
+
+        /**
+         * @brief Fusion of the outputs of an ensemble
+         */
+        enum class Fusion {
+            Average, ///< Average of the softmax outputs
+            Vote     ///< Share of the CNNs voting for a class with their top-1 class
+        };
+
+        /**
+         * @brief Temporal filter of the results of consecutive frames
+         */
+        struct Smoothing {
+            enum class Mode {
+                None,      ///< Every frame decides on its own
+                Ema,       ///< Exponential moving average of the probabilities
+                Hysteresis ///< Decision changes if a class was top-1 in n of the last m frames
+            };
+            Mode mode = Mode::None;
+            double alpha = 1.;
+            int n = 1;
+            int m = 1;
+        };
+
+        /**
+         * @brief Rule which decides if the result of a ROI is OK
+         */
+        struct OkRule {
+            QStringList classes; // OK classes, an empty list means the ROI is not part of the verdict
+            double threshold = 0.; // minimum probability of the decided class
+        };
+
         /**
          * @brief C'tor
          * @param roiName Name of the ROI
@@ -29,14 +72,249 @@ public:
         QString roiName() const;
         QRect roiRect() const;
         QString cnn() const;
+        int priority() const;
+
+        /**
+         * @brief Getter for the user-defined shard key
+         * @return Shard key, empty if not set
+         */
+        QString shard() const;
+
+        /**
+         * @brief Getter for the critical flag
+         * @return True if the ROI keeps its full rate when the vision app is overloaded
+         */
+        bool critical() const;
+
+        /**
+         * @brief Getter for the cascade stages
+         * @return Stages evaluated in order before the CNN. The first stage whose top-1 probability reaches its
+         * threshold decides, the CNN is only evaluated if no stage is confident enough.
+         */
+        QList<CascadeStage> cascade() const;
+
+        /**
+         * @brief Getter for the ensemble
+         * @return Further CNNs which classify the ROI together with the CNN
+         */
+        QStringList ensemble() const;
+
+        /**
+         * @brief Getter for the fusion of the ensemble outputs
+         * @return Fusion
+         */
+        Fusion fusion() const;
+
+        /**
+         * @brief Getter for the temporal filter
+         * @return Smoothing
+         */
+        Smoothing smoothing() const;
+
+        /**
+         * @brief Getter for the OK rule
+         * @return Rule, the ROI is OK if its decided class is an OK class with at least the threshold probability
+         */
+        OkRule okRule() const;
+
+        /**
+         * @brief Getter for all CNNs used by this ROI
+         * @return CNNs of the cascade stages followed by the CNN and the ensemble
+         */
+        QStringList cnns() const;
+
         void setRoiName(const QString& roiName);
         void setRoiRect(QRect rect);
         void setCnn(const QString& cnn);
+        void setPriority(int priority);
+        void setShard(const QString& shard);
+        void setCritical(bool critical);
+        void setCascade(const QList<CascadeStage>& cascade);
+        void setEnsemble(const QStringList& ensemble, Fusion fusion);
+        void setSmoothing(const Smoothing& smoothing);
+        void setOkRule(const OkRule& okRule);
 
     private:
         QString _roiName;
         QRect _roiRect;
         QString _cnn;
+        int _priority = 0;
+        QString _shard;
+        bool _critical = false;
+        QList<CascadeStage> _cascade;
+        QStringList _ensemble;
+        Fusion _fusion = Fusion::Average;
+        Smoothing _smoothing;
+        OkRule _okRule;
+    };
+
+    /**
+     * @brief Global settings of a configuration
+     */
+    class Settings {
+    public:
+        /**
+         * @brief Rule which combines the OK results of the ROIs to the frame verdict
+         */
+        enum class Verdict {
+            All,  ///< All ROIs with an OK rule are OK
+            Any,  ///< At least one of them is OK
+            Count ///< At least verdictMinOk of them are OK
+        };
+
+        Settings() = default;
+
+        /**
+         * @brief C'tor
+         * @param map Settings map
+         */
+        Settings(const QVariantMap& map);
+
+        QVariantMap toMap() const;
+        void loadMap(const QVariantMap& map);
+
+        /**
+         * @brief Getter for the number of vision objects created in advance on activation
+         * @return Number of vision objects, 0 creates them lazily on demand
+         */
+        int visionPoolSize() const;
+
+        /**
+         * @brief Getter for the warm-up flag
+         * @return True if every CNN runs one dummy inference on activation
+         */
+        bool warmUp() const;
+
+        /**
+         * @brief Getter for the processing time budget of a frame
+         * @return Budget in ms, 0 if ROIs are never skipped
+         */
+        int frameBudgetMs() const;
+
+        /**
+         * @brief Getter for the publish mode
+         * @return True if ROI results are only published when their decision changed
+         */
+        bool publishOnChange() const;
+
+        /**
+         * @brief Getter for the heartbeat interval in publish on change mode
+         * @return Interval in ms after which a ROI result is published even without change, 0 disables it
+         */
+        int heartbeatMs() const;
+
+        /**
+         * @brief Getter for the number of engines the ROIs are split across
+         * @return Number of shards, 1 processes all ROIs in one engine
+         */
+        int shards() const;
+
+        /**
+         * @brief Getter for the shard assignment
+         * @return True if ROIs are split by their shard key, false if they are split by CNN
+         */
+        bool shardByKey() const;
+
+        /**
+         * @brief Getter for the update interval of the metrics
+         * @return Interval in ms, 0 disables the metrics
+         */
+        int metricsIntervalMs() const;
+
+        /**
+         * @brief Getter for the maximum size of a capture file
+         * @return Size in MB
+         */
+        int captureSizeMb() const;
+
+        /**
+         * @brief Getter for the replay rate
+         * @return True if a capture is replayed at the recorded rate, false if at maximum rate
+         */
+        bool replayOriginalRate() const;
+
+        /**
+         * @brief Getter for the latency limit of a frame above which the vision app degrades its processing
+         * @return Limit in ms, 0 disables the overload control
+         */
+        int overloadLatencyMs() const;
+
+        /**
+         * @brief Getter for the rate of the ROIs which are not critical under overload
+         * @return They are evaluated in every n-th frame
+         */
+        int overloadSubsample() const;
+
+        /**
+         * @brief Getter for the sensor readout
+         * @return True if the sensor AOI is the bounding union of the ROIs, false if the full sensor is read out
+         */
+        bool sensorAoiFromRois() const;
+
+        /**
+         * @brief Getter for the classes whose ROI crops are saved as evidence
+         * @return Class names
+         */
+        QStringList evidenceClasses() const;
+
+        /**
+         * @brief Getter for the confidence below which ROI crops are saved as evidence
+         * @return Probability, 0 saves only the evidence classes
+         */
+        double evidenceThreshold() const;
+
+        /**
+         * @brief Getter for the image format of the evidence
+         * @return True for PNG, false for JPEG
+         */
+        bool evidencePng() const;
+
+        /**
+         * @brief Getter for the size cap of the evidence
+         * @return Size in MB
+         */
+        int evidenceSizeMb() const;
+
+        /**
+         * @brief Getter for the frame verdict rule
+         * @return Rule
+         */
+        Verdict verdict() const;
+
+        /**
+         * @brief Getter for the number of OK ROIs needed by the Count verdict
+         * @return Number of ROIs
+         */
+        int verdictMinOk() const;
+
+        /**
+         * @brief Getter for the output format of a CNN
+         * @param cnn Name of the CNN
+         * @return Configured output format, the native one if not configured
+         */
+        OutputFormat outputFormat(const QString& cnn) const;
+
+    private:
+        int _visionPoolSize = 0;
+        bool _warmUp = true;
+        int _frameBudgetMs = 0;
+        bool _publishOnChange = false;
+        int _heartbeatMs = 0;
+        int _shards = 1;
+        bool _shardByKey = false;
+        int _metricsIntervalMs = 0;
+        int _captureSizeMb = 64;
+        bool _replayOriginalRate = false;
+        int _overloadLatencyMs = 0;
+        int _overloadSubsample = 4;
+        bool _sensorAoiFromRois = false;
+        QStringList _evidenceClasses;
+        double _evidenceThreshold = 0.;
+        bool _evidencePng = false;
+        int _evidenceSizeMb = 256;
+        Verdict _verdict = Verdict::All;
+        int _verdictMinOk = 1;
+        QMap<QString, OutputFormat> _outputFormats;
     };
 
     CnnRoiConfig() = default;
@@ -56,6 +334,7 @@ public:
     void saveConfig();
     QList<CnnRoiMap> getCnnRois() const;
     CnnRoiMap getCnnRoi(const QString& cnn);
+    Settings settings() const;
 
     /**
      * @brief Getter for maximum supported ROIs
@@ -67,4 +346,5 @@ private:
     void parseConfig(const QJsonObject& config);
     QString _roiConfigFile;
     QVariantMap _cnnRois;
+    Settings _settings;
 };
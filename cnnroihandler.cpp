@@ -1,15 +1,21 @@
 ﻿#include "cnnroihandler.h"
 
 #include <QLoggingCategory>
+#include <QSet>
+#include <algorithm>
 #include <cmath>
 
 #include <frameworkapplication.h>
 
+#include "trace.h"
+
 using namespace IDS::NXT;
 using namespace IDS::NXT::CNNv2;
 
 static QLoggingCategory lc{"multicnnclassifier.cnnroihandler"};
 
+static constexpr int DESCRIPTION_INTERVAL_MS = 250;
+
 CnnRoiHandler::CnnRoiHandler()
   : _cnnRoiConfigFile{"cnnconfig", false, true, "json"}
   , _cnnFile{"cnnfile", false, true, "cnn"}
@@ -25,6 +31,9 @@ CnnRoiHandler::CnnRoiHandler()
     filtercnn.append("IDS NXT rio/rome classification model |*.rcla; *.cnn");
     _cnnFile.setFilter(filtercnn);
     _cnnFile.setDeletable(true);
+    _descriptionTimer.setSingleShot(true);
+    _descriptionTimer.setInterval(DESCRIPTION_INTERVAL_MS);
+    connect(&_descriptionTimer, &QTimer::timeout, this, &CnnRoiHandler::rebuildInstalledCnnDescription);
     // Connect framework signals to local slot
     connect(&CnnManager::getInstance(), &CnnManager::cnnChanged, this, &CnnRoiHandler::cnnChanged);
     connect(&CnnManager::getInstance(), &CnnManager::installedCnnsChanged, this, &CnnRoiHandler::installedCnnsChanged);
@@ -44,12 +53,63 @@ CnnRoiHandler::CnnRoiHandler()
 
 void CnnRoiHandler::cnnChanged() {
     qCDebug(lc) << "cnnChanged";
+    {
+        // the CNN data of the plan entries and the memory figures may be outdated
+        std::lock_guard<std::mutex> locker(_updateLock);
+        _plan.clear();
+        _cnnMemoryMb.clear();
+    }
     roiOrCnnOrConfigChanged();
 }
 
 void CnnRoiHandler::roiChanged() {
     qCDebug(lc) << "roiChanged";
-    roiOrCnnOrConfigChanged();
+    if (!updateRoiRects()) {
+        roiOrCnnOrConfigChanged();
+    }
+}
+
+bool CnnRoiHandler::updateRoiRects() {
+    std::lock_guard<std::mutex> locker(_updateLock);
+
+    // A moved ROI only changes its rectangle. If the ROI manager still holds exactly the ROIs of the active list,
+    // everything else of the list stays valid.
+    const auto activeList = activeRoiCnnList();
+    const auto managedRois = _roiManager.managedROIs();
+    if (activeList->isEmpty() || managedRois.size() != activeList->size()
+        || activeList->size() != _cnnRoiConfig.getCnnRois().size()) {
+        return false;
+    }
+
+    auto newList = *activeList;
+    auto movedRois = 0;
+    for (auto& roiCnn : newList) {
+        const auto managedRoi = managedRois.value(roiCnn.roiName);
+        if (!managedRoi) {
+            return false;
+        }
+        const auto rect = managedRoi->getQRect();
+        if (rect != roiCnn.roi) {
+            roiCnn.roi = rect;
+            if (_plan.contains(roiCnn.roiName)) {
+                _plan[roiCnn.roiName].roiCnn.roi = rect;
+            }
+            movedRois++;
+        }
+    }
+    qCDebug(lc) << "Moved" << movedRois << "ROIs";
+    if (movedRois == 0) {
+        return true;
+    }
+
+    const auto sensorAoi = this->sensorAoi().rect();
+    publishActiveRoiCnnList(std::move(newList), true);
+    // the description only shows the sensor AOI of the ROI positions
+    if (this->sensorAoi().rect() != sensorAoi) {
+        updateInstalledCnnDescription();
+    }
+
+    return true;
 }
 
 void CnnRoiHandler::roiOrCnnOrConfigChanged() {
@@ -61,6 +121,7 @@ void CnnRoiHandler::roiOrCnnOrConfigChanged() {
     QSignalBlocker blockerCnnManager(&CnnManager::getInstance());
 
     qCDebug(lc) << "roiOrCnnOrConfigChanged run";
+    Trace::Span span("configReload");
     MyVision::RoiCnnList newList;
     QList<CnnData> activeCnns;
     try {
@@ -80,20 +141,31 @@ void CnnRoiHandler::roiOrCnnOrConfigChanged() {
 
     bool skipInit = false;
     for (const auto& loadedRoiCnn : loadedRoiCnns) {
-        if (!installedCnns.contains(loadedRoiCnn.cnn())) {
-            qCDebug(lc) << loadedRoiCnn.cnn() << "not installed. Skip init";
-            skipInit = true;
+        for (const auto& cnn : loadedRoiCnn.cnns()) {
+            if (!installedCnns.contains(cnn)) {
+                qCDebug(lc) << cnn << "not installed. Skip init";
+                skipInit = true;
+            }
         }
         loadedRois.append(loadedRoiCnn.roiName());
     }
-    // rois of config already defined
-    if (loadedRois != activeRois && !loadedRoiCnns.isEmpty()) {
-        qCDebug(lc) << "Rois not active, activate";
-        _roiManager.clearROIs();
+    // rois of config already defined. Only the missing ones are added, all of them are recreated only if the ROI
+    // manager holds ROIs which are not configured anymore. The manager lists its ROIs sorted by name.
+    if (!loadedRoiCnns.isEmpty()) {
+        const auto obsoleteRois = std::any_of(activeRois.begin(), activeRois.end(), [&loadedRois](const QString& roi) {
+            return !loadedRois.contains(roi);
+        });
+        if (obsoleteRois) {
+            qCDebug(lc) << "Rois not configured anymore, recreate all";
+            _roiManager.clearROIs();
+        }
         // only set rois here, because rois are defined in config
         for (const auto& loadedRoiCnn : loadedRoiCnns) {
-            const auto rect = loadedRoiCnn.roiRect();
-            _roiManager.addROI(loadedRoiCnn.roiName(), rect.x(), rect.y(), rect.width(), rect.height());
+            if (obsoleteRois || !activeRois.contains(loadedRoiCnn.roiName())) {
+                qCDebug(lc) << "Roi not active, activate" << loadedRoiCnn.roiName();
+                const auto rect = loadedRoiCnn.roiRect();
+                _roiManager.addROI(loadedRoiCnn.roiName(), rect.x(), rect.y(), rect.width(), rect.height());
+            }
         }
     }
 
@@ -110,15 +182,16 @@ void CnnRoiHandler::roiOrCnnOrConfigChanged() {
     auto cnnsForDeactivation = installedCnns;
     QStringList cnnsForActivation;
     for (const auto& loadedRoi : loadedRoiCnns) {
-        const auto cnn = loadedRoi.cnn();
-        if (!installedCnns.contains(cnn)) {
-            qCDebug(lc) << "CNN not installed" << cnn;
-            continue;
-        }
-        cnnsForDeactivation.removeAll(cnn);
-        if (!activeCnnList.contains(cnn)) {
-            qCDebug(lc) << "CNN not active. Enable it." << cnn;
-            cnnsForActivation.append(cnn);
+        for (const auto& cnn : loadedRoi.cnns()) {
+            if (!installedCnns.contains(cnn)) {
+                qCDebug(lc) << "CNN not installed" << cnn;
+                continue;
+            }
+            cnnsForDeactivation.removeAll(cnn);
+            if (!activeCnnList.contains(cnn) && !cnnsForActivation.contains(cnn)) {
+                qCDebug(lc) << "CNN not active. Enable it." << cnn;
+                cnnsForActivation.append(cnn);
+            }
         }
     }
     qCDebug(lc) << "CNN to deactivate" << cnnsForDeactivation;
@@ -145,41 +218,151 @@ void CnnRoiHandler::roiOrCnnOrConfigChanged() {
         return;
     }
     try {
-        if (!cnnsForActivation.isEmpty())
+        if (!cnnsForActivation.isEmpty()) {
             CnnManager::getInstance().enableCnns(cnnsForActivation, true);
+            // the CNNs enabled just now are not part of the list fetched before
+            activeCnns = CnnManager::getInstance().activeCnns();
+        }
     } catch (std::runtime_error& e) {
         qCritical(lc) << "Error enabling cnns:" << e.what();
         return;
     }
-    auto getCnnData = [](const QList<CnnData>& allCNNs, const QString& cnn) {
-        for (const auto& oneCNN : allCNNs) {
-            if (cnn == oneCNN.name()) {
-                return oneCNN;
-            }
-        }
-        return CnnData{};
+    QHash<QString, CnnData> activeCnnsByName;
+    for (const auto& cnn : qAsConst(activeCnns)) {
+        activeCnnsByName.insert(cnn.name(), cnn);
+    }
+    auto getCnnData = [&activeCnnsByName](const QString& cnn) {
+        return activeCnnsByName.value(cnn);
     };
 
+    const auto settings = _cnnRoiConfig.settings();
+    // the plan entries depend on the settings, e.g. on the output formats
+    const auto settingsMap = settings.toMap();
+    if (settingsMap != _planSettings) {
+        _plan.clear();
+        _planSettings = settingsMap;
+    }
+    const auto managedRois = _roiManager.managedROIs();
+    QHash<QString, PlanEntry> newPlan;
+    auto reusedEntries = 0;
+    QHash<QString, int> shardOfKey;
+    auto verdictBits = 0;
     for (const auto& cnnRoi : loadedRoiCnns) {
-        // create Vision Data
+        // an unchanged ROI keeps its plan entry, only its position is taken from the ROI manager again
+        const auto config = cnnRoi.toMap();
+        const auto planIter = _plan.constFind(cnnRoi.roiName());
         MyVision::RoiCnn thisRoiCNN;
-        thisRoiCNN.cnnData = getCnnData(activeCnns, cnnRoi.cnn());
-        thisRoiCNN.roiName = cnnRoi.roiName();
-        const auto managedRois = _roiManager.managedROIs();
+        if (planIter != _plan.constEnd() && planIter->config == config) {
+            thisRoiCNN = planIter->roiCnn;
+            reusedEntries++;
+        } else {
+            try {
+                // create Vision Data
+                thisRoiCNN.cnnData = getCnnData(cnnRoi.cnn());
+                thisRoiCNN.descriptor = descriptor(thisRoiCNN.cnnData);
+                thisRoiCNN.roiName = cnnRoi.roiName();
+                thisRoiCNN.priority = cnnRoi.priority();
+                thisRoiCNN.critical = cnnRoi.critical();
+                thisRoiCNN.outputFormats.append(settings.outputFormat(cnnRoi.cnn()));
+                QStringList ensembleNames{thisRoiCNN.descriptor->name()};
+                for (const auto& member : cnnRoi.ensemble()) {
+                    const auto memberData = getCnnData(member);
+                    const auto memberDescriptor = descriptor(memberData);
+                    // the outputs are fused class by class, so all members need the same classes
+                    if (memberDescriptor->classTable()->names() != thisRoiCNN.descriptor->classTable()->names()) {
+                        throw std::runtime_error("Classes of ensemble " + member.toStdString() + " differ from "
+                                                 + thisRoiCNN.descriptor->name().toStdString());
+                    }
+                    thisRoiCNN.ensemble.append(memberData);
+                    thisRoiCNN.ensembleDescriptors.append(memberDescriptor);
+                    thisRoiCNN.outputFormats.append(settings.outputFormat(member));
+                    ensembleNames.append(memberDescriptor->name());
+                }
+                thisRoiCNN.fusion = cnnRoi.fusion();
+                thisRoiCNN.smoothing = cnnRoi.smoothing();
+                thisRoiCNN.jsonPrefix = jsonPrefix(ensembleNames.join('+'), thisRoiCNN.roiName);
+                thisRoiCNN.okClasses = okClasses(*thisRoiCNN.descriptor->classTable(), cnnRoi.okRule().classes);
+                thisRoiCNN.okThreshold = cnnRoi.okRule().threshold;
+                for (const auto& stage : cnnRoi.cascade()) {
+                    MyVision::CnnStage thisStage;
+                    thisStage.cnnData = getCnnData(stage.cnn);
+                    thisStage.descriptor = descriptor(thisStage.cnnData);
+                    thisStage.jsonPrefix = jsonPrefix(thisStage.descriptor->name(), thisRoiCNN.roiName);
+                    thisStage.outputFormat = settings.outputFormat(stage.cnn);
+                    thisStage.threshold = stage.threshold;
+                    thisStage.okClasses = okClasses(*thisStage.descriptor->classTable(), cnnRoi.okRule().classes);
+                    thisRoiCNN.cascade.append(thisStage);
+                }
+            } catch (const std::runtime_error& e) {
+                qCritical(lc) << "can not activate CnnRoiConfig." << e.what();
+                updateInstalledCnnDescription();
+                return;
+            }
+        }
+        // distinct keys are distributed round robin, ROIs without shard key are split by their CNN
+        const auto shardKey = settings.shardByKey() && !cnnRoi.shard().isEmpty() ? cnnRoi.shard() : cnnRoi.cnn();
+        if (!shardOfKey.contains(shardKey)) {
+            shardOfKey.insert(shardKey, shardOfKey.size() % settings.shards());
+        }
+        thisRoiCNN.shard = shardOfKey.value(shardKey);
+        // the bits of the OK mask follow the order of the ROI names
+        thisRoiCNN.verdictBit = cnnRoi.okRule().classes.isEmpty() ? -1 : verdictBits++;
         if (managedRois.contains(thisRoiCNN.roiName)) {
             thisRoiCNN.roi = managedRois.value(thisRoiCNN.roiName)->getQRect();
         } else {
             thisRoiCNN.roi = cnnRoi.roiRect();
         }
+        newPlan.insert(thisRoiCNN.roiName, PlanEntry{config, thisRoiCNN});
         newList.append(thisRoiCNN);
     }
+    qCDebug(lc) << "Reused" << reusedEntries << "of" << loadedRoiCnns.size() << "plan entries";
+    _plan = newPlan;
 
-    _activeRoiCnnList.clear();
-    _activeRoiCnnList = newList;
+    // ROIs are processed in this order, so the high priority ones are evaluated before the frame budget runs out
+    std::stable_sort(newList.begin(), newList.end(), [](const MyVision::RoiCnn& lhs, const MyVision::RoiCnn& rhs) {
+        return lhs.priority > rhs.priority;
+    });
+
+    publishActiveRoiCnnList(std::move(newList));
 
     updateInstalledCnnDescription();
 }
 
+QVector<bool> CnnRoiHandler::okClasses(const CnnClassTable& classTable, const QStringList& classes) {
+    QVector<bool> okClasses(classTable.size(), false);
+    for (auto index = 0; index < classTable.size(); index++) {
+        okClasses[index] = classes.contains(classTable.name(index));
+    }
+
+    return okClasses;
+}
+
+QByteArray CnnRoiHandler::jsonPrefix(const QString& cnn, const QString& roi) {
+    return "{\"CNN\":" + CnnClassTable::jsonString(cnn) + ",\"ROI\":" + CnnClassTable::jsonString(roi)
+           + ",\"Result\":";
+}
+
+std::shared_ptr<const CnnDescriptor> CnnRoiHandler::descriptor(const CnnData& cnnData) {
+    const auto classes = cnnData.classes();
+    auto& cached = _descriptors[cnnData.name()];
+
+    // Rebuild the descriptor only if the CNN is new or was replaced by one with other classes or input size. The
+    // class table is kept if only the input size changed.
+    if (!cached || cached->classTable()->names() != classes || cached->inputSize() != cnnData.inputSize()) {
+        auto classTable = cached && cached->classTable()->names() == classes
+                              ? cached->classTable()
+                              : std::make_shared<const CnnClassTable>(classes);
+        try {
+            cached = std::make_shared<const CnnDescriptor>(cnnData, std::move(classTable));
+        } catch (const std::runtime_error&) {
+            _descriptors.remove(cnnData.name());
+            throw;
+        }
+    }
+
+    return cached;
+}
+
 void CnnRoiHandler::updateTotalCnnMemory() {
     _totalCnnMemory = CnnManager::getInstance().availableCnnMemory() / 1024 / 1024;
 }
@@ -228,12 +411,18 @@ void CnnRoiHandler::deleteCnnConfig() {
         qCDebug(lc) << "can not load roiconfig" << e.what();
     }
     _roiManager.clearROIs();
-    _activeRoiCnnList.clear();
+    publishActiveRoiCnnList({});
     updateInstalledCnnDescription();
 }
 
 void CnnRoiHandler::deleteAllCNNs() {
-    _activeRoiCnnList.clear();
+    publishActiveRoiCnnList({});
+    {
+        std::lock_guard<std::mutex> locker(_updateLock);
+        _plan.clear();
+        _descriptors.clear();
+        _cnnMemoryMb.clear();
+    }
     {
         // disable all signals temporary to prevent multiple function calls on every change
         QSignalBlocker blockerRoiManager(&_roiManager);
@@ -249,12 +438,49 @@ void CnnRoiHandler::deleteAllCNNs() {
     updateInstalledCnnDescription();
 }
 
-MyVision::RoiCnnList CnnRoiHandler::activeRoiCnnList() const {
-    return _activeRoiCnnList;
+MyVision::RoiCnnListPtr CnnRoiHandler::activeRoiCnnList() const {
+    return _activeRoiCnnList.load();
+}
+
+void CnnRoiHandler::publishActiveRoiCnnList(MyVision::RoiCnnList list, bool roisMoved) {
+    // the AOI is published first, so an engine set up with the new list already translates its ROIs
+    QList<QRect> rois;
+    if (_cnnRoiConfig.settings().sensorAoiFromRois()) {
+        for (const auto& roiCnn : qAsConst(list)) {
+            rois.append(roiCnn.roi);
+        }
+    }
+    _sensorAoi.store(std::make_shared<const SensorAoi>(SensorAoi::boundingUnion(rois)));
+
+    // Readers keep their snapshot alive by reference counting, so the old list is released only after the last
+    // vision object using it has been set up with a newer one.
+    _activeRoiCnnList.store(std::make_shared<const MyVision::RoiCnnList>(std::move(list)));
+    if (roisMoved) {
+        emit activeRoisMoved();
+    } else {
+        emit activeRoiCnnListChanged();
+    }
+}
+
+CnnRoiConfig::Settings CnnRoiHandler::settings() const {
+    return _cnnRoiConfig.settings();
+}
+
+qint64 CnnRoiHandler::cnnMemoryHeadroom() const {
+    return _totalCnnMemory - _neededCnnMemory;
+}
+
+SensorAoi CnnRoiHandler::sensorAoi() const {
+    return *_sensorAoi.load();
 }
 
 void CnnRoiHandler::installedCnnsChanged() {
     qCDebug(lc) << "installedCnnsChanged";
+    {
+        std::lock_guard<std::mutex> locker(_updateLock);
+        _plan.clear();
+        _cnnMemoryMb.clear();
+    }
 
     roiOrCnnOrConfigChanged();
     updateInstalledCnnDescription();
@@ -280,88 +506,124 @@ void CnnRoiHandler::installCnn() {
 }
 
 void CnnRoiHandler::updateInstalledCnnDescription() {
-    qCDebug(lc) << "updateInstalledCnnDescription";
-    const auto installedCNNs = CnnManager::getInstance().availableCnns();
-    const auto cnnRoiConfig = _cnnRoiConfig.getCnnRois();
-    auto managedRois = _roiManager.managedROIs().keys();
-
-    auto isActive = [&](const QString& cnn) -> bool {
-        for (const auto& cnnRoi : qAsConst(_activeRoiCnnList)) {
-            if (cnn == cnnRoi.cnnData.name()) {
-                return true;
+    // the timer belongs to the main thread, the changes may be reported from others
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            if (!_descriptionTimer.isActive()) {
+                _descriptionTimer.start();
             }
-        }
+        },
+        Qt::QueuedConnection);
+}
 
-        return false;
-    };
+void CnnRoiHandler::rebuildInstalledCnnDescription() {
+    Trace::Span span("describeCnns");
+    qCDebug(lc) << "rebuildInstalledCnnDescription";
 
-    auto getNeededMemoryOfCNN = [&](const QString& cnn) -> float {
-        return static_cast<float>(CnnManager::getInstance().neededCnnMemory(cnn)) / 1024 / 1024;
-    };
+    _cnnFile.setDescription(TranslatedText(installedCnnDescription()));
+}
 
-    CnnRoiTextCreator text;
-    auto notUsedCnns = installedCNNs;
-    qint64 neededCnnMemory = 0;
+float CnnRoiHandler::cnnMemoryMb(const QString& cnn) {
+    auto iter = _cnnMemoryMb.find(cnn);
+    if (iter == _cnnMemoryMb.end()) {
+        const auto memory = static_cast<float>(CnnManager::getInstance().neededCnnMemory(cnn)) / 1024 / 1024;
+        qCDebug(lc) << "neededCnnMemoryInMByte" << cnn << memory;
+        iter = _cnnMemoryMb.insert(cnn, memory);
+    }
 
-    for (const auto& cnn : cnnRoiConfig) {
-        auto roiText = cnn.roiName();
-        auto cnnText = cnn.cnn();
+    return *iter;
+}
 
-        if (isActive(cnn.cnn())) {
-            roiText = QStringLiteral("[ %1 ]✔").arg(roiText);
-        } else {
-            roiText = QStringLiteral("[ %1 ]✖").arg(roiText);
+QMap<QString, QString> CnnRoiHandler::installedCnnDescription() {
+    CnnRoiTextCreator text;
+    const auto installedCnns = CnnManager::getInstance().availableCnns();
+    auto notUsedCnns = installedCnns;
+    auto unusedRois = _roiManager.managedROIs().keys();
+
+    QSet<QString> activeCnns;
+    for (const auto& cnnRoi : *activeRoiCnnList()) {
+        activeCnns.insert(cnnRoi.cnnData.name());
+        for (const auto& stage : cnnRoi.cascade) {
+            activeCnns.insert(stage.cnnData.name());
+        }
+        for (const auto& member : cnnRoi.ensemble) {
+            activeCnns.insert(member.name());
         }
+    }
 
-        if (installedCNNs.contains(cnn.cnn())) {
-            const auto neededCnnMemoryInMByte = getNeededMemoryOfCNN(cnn.cnn());
-            neededCnnMemory += static_cast<quint64>(std::ceil(neededCnnMemoryInMByte));
-            qCDebug(lc) << "neededCnnMemoryInMByte" << cnn.cnn() << neededCnnMemoryInMByte;
-            cnnText.append(QStringLiteral(" (%1MB)").arg(std::ceil(neededCnnMemoryInMByte), 0, 'f', 0));
-        } else {
-            cnnText.append(" ( - )");
+    qint64 neededCnnMemory = 0;
+    for (const auto& cnnRoi : _cnnRoiConfig.getCnnRois()) {
+        // one row for every CNN of the ROI, cascade stages first
+        for (const auto& cnn : cnnRoi.cnns()) {
+            auto roiText = cnnRoi.roiName();
+            auto cnnText = cnn;
+
+            if (activeCnns.contains(cnn)) {
+                roiText = QStringLiteral("[ %1 ]✔").arg(roiText);
+            } else {
+                roiText = QStringLiteral("[ %1 ]✖").arg(roiText);
+            }
+
+            if (installedCnns.contains(cnn)) {
+                const auto neededCnnMemoryInMByte = cnnMemoryMb(cnn);
+                neededCnnMemory += static_cast<qint64>(std::ceil(neededCnnMemoryInMByte));
+                cnnText.append(QStringLiteral(" (%1MB)").arg(std::ceil(neededCnnMemoryInMByte), 0, 'f', 0));
+            } else {
+                cnnText.append(" ( - )");
+            }
+            text.addRow(cnnText, roiText);
+            // create list of installed but not used cnns
+            notUsedCnns.removeAll(cnn);
         }
-        text.addRow(cnnText, roiText);
-        // create list of installed but not used cnns and rois
-        notUsedCnns.removeAll(cnn.cnn());
-        managedRois.removeAll(cnn.roiName());
+        unusedRois.removeAll(cnnRoi.roiName());
     }
+    _neededCnnMemory = neededCnnMemory;
 
     // add not used cnns to list
-    for (const auto& cnn : notUsedCnns) {
-        const auto neededCnnMemoryInMByte = getNeededMemoryOfCNN(cnn);
-        qCDebug(lc) << "neededCnnMemoryInMByte" << cnn << neededCnnMemoryInMByte;
+    for (const auto& cnn : qAsConst(notUsedCnns)) {
+        const auto neededCnnMemoryInMByte = cnnMemoryMb(cnn);
         text.addRow(QStringLiteral("%1 (%2MB)").arg(cnn, QString::number(std::ceil(neededCnnMemoryInMByte), 'f', 0)),
                     QStringLiteral("[ - ]✖"));
     }
 
     // add not used rois to list
-    for (const auto& roi : qAsConst(managedRois)) {
+    for (const auto& roi : qAsConst(unusedRois)) {
         text.addRow(QStringLiteral(" ( - )"), QStringLiteral("[ %1 ]✖").arg(roi));
     }
 
-    const auto description = FrameworkApplication::manifest().getTranslatedText(
+    static const auto description = FrameworkApplication::manifest().getTranslatedText(
         QStringLiteral("Language.cnnfile.Description"));
-
     QString newDescriptionEN = description.translation(QStringLiteral("en"));
     QString newDescriptionDE = description.translation(QStringLiteral("de"));
 
     newDescriptionEN.append(text);
     newDescriptionDE.append(text);
 
-    const auto freeMemory = _totalCnnMemory - neededCnnMemory;
-
+    const auto freeMemory = cnnMemoryHeadroom();
     newDescriptionEN.append(QStringLiteral("-------------------------------------------------------------------\n\r"));
     newDescriptionEN.append(QStringLiteral("Available CNN Memory: %1MB / %2MB").arg(freeMemory).arg(_totalCnnMemory));
     newDescriptionDE.append(QStringLiteral("-------------------------------------------------------------------\n\r"));
     newDescriptionDE.append(
         QStringLiteral("Verfügbarer CNN Speicher: %1MB / %2MB").arg(freeMemory).arg(_totalCnnMemory)); //
 
+    // the camera has to read out this AOI, so it is shown with the configuration
+    const auto aoi = sensorAoi().rect();
+    if (aoi.isValid()) {
+        const auto aoiText = QStringLiteral(": %1, %2, %3 x %4 px")
+                                 .arg(aoi.x())
+                                 .arg(aoi.y())
+                                 .arg(aoi.width())
+                                 .arg(aoi.height());
+        newDescriptionEN.append(QStringLiteral("\n\rSensor AOI") + aoiText);
+        newDescriptionDE.append(QStringLiteral("\n\rSensor-AOI") + aoiText);
+    }
+
     QMap<QString, QString> translations;
     translations.insert(QStringLiteral("en"), newDescriptionEN);
     translations.insert(QStringLiteral("de"), newDescriptionDE);
-    TranslatedText newDescription(translations);
-    _cnnFile.setDescription(newDescription);
+
+    return translations;
 }
 
 void CnnRoiTextCreator::addRow(const QString& cnn, const QString& roi) {
@@ -1,7 +1,10 @@
 #pragma once
 #include "cnnroiconfig.h"
 
+#include <QHash>
 #include <QObject>
+#include <QTimer>
+#include <atomic>
 #include <mutex>
 
 #include <cnnmanager_v2.h>
@@ -9,6 +12,10 @@
 #include <myvision.h>
 #include <roimanager.h>
 
+#include "cnndescriptor.h"
+#include "rcupointer.h"
+#include "sensoraoi.h"
+
 /**
  * @brief This class is used to create the description of the set configuration
  * which is displayed in the NXT Cockpit
@@ -34,7 +41,53 @@ class CnnRoiHandler : public QObject {
 public:
     CnnRoiHandler();
 
-    MyVision::RoiCnnList activeRoiCnnList() const;
+    /**
+     * @brief Getter for the active ROI/CNN list
+     * @return Snapshot of the active list, which stays valid and unchanged while it is held
+     *
+     * The list is published read-copy-update style: every change builds a new list and swaps the pointer
+     * atomically. Readers never wait for a running reconfiguration and never see a partially updated list.
+     */
+    MyVision::RoiCnnListPtr activeRoiCnnList() const;
+
+    /**
+     * @brief Getter for the global settings of the loaded configuration
+     * @return Settings
+     */
+    CnnRoiConfig::Settings settings() const;
+
+    /**
+     * @brief Getter for the CNN memory which is left by the configured CNNs
+     * @return Free CNN memory in MB
+     */
+    qint64 cnnMemoryHeadroom() const;
+
+    /**
+     * @brief Builds the description of the CNN file with the installed CNNs and the memory figures
+     * @return Description by language
+     *
+     * The description shown in the cockpit is built the same way.
+     */
+    QMap<QString, QString> installedCnnDescription();
+
+    /**
+     * @brief Getter for the sensor AOI of the active ROI/CNN list
+     * @return Bounding union of the active ROIs if the settings ask for it, the full sensor otherwise
+     */
+    SensorAoi sensorAoi() const;
+
+signals:
+    /**
+     * @brief Emitted whenever a new active ROI/CNN list was published
+     */
+    void activeRoiCnnListChanged();
+
+    /**
+     * @brief Emitted when the active ROI/CNN list was republished because ROIs were moved
+     *
+     * Only the rectangles of the ROIs changed, the CNNs, the settings and the temporal state stay valid.
+     */
+    void activeRoisMoved();
 
 private slots:
     void cnnChanged();
@@ -44,19 +97,85 @@ private slots:
     void loadRoiCnnConfig();
     void deleteCnnConfig();
 
+    /**
+     * @brief Rebuilds the outdated description of the CNN file
+     */
+    void rebuildInstalledCnnDescription();
+
 private:
+    /**
+     * @brief Marks the description of the CNN file as outdated
+     *
+     * Several changes in a row, e.g. of a bulk upload of CNNs, are coalesced into one rebuild per interval.
+     */
+    void updateInstalledCnnDescription();
+
+    /**
+     * @brief Getter for the memory needed by an installed CNN
+     * @param cnn Name of the CNN
+     * @return Cached memory in MB, it is queried again only after the installed CNNs changed
+     */
+    float cnnMemoryMb(const QString& cnn);
+
     void roiOrCnnOrConfigChanged();
+
+    /**
+     * @brief Takes over moved ROIs without rebuilding the active ROI/CNN list
+     * @return False if the ROIs changed in another way and the list has to be rebuilt
+     */
+    bool updateRoiRects();
     void updateTotalCnnMemory();
-    void updateInstalledCnnDescription();
     void deleteAllCNNs();
 
+    /**
+     * @brief Publishes a new active ROI/CNN list together with its sensor AOI
+     * @param list New list
+     * @param roisMoved True if only the rectangles of the ROIs differ from the previous list
+     */
+    void publishActiveRoiCnnList(MyVision::RoiCnnList list, bool roisMoved = false);
+    static QByteArray jsonPrefix(const QString& cnn, const QString& roi);
+
+    /**
+     * @brief Looks up the OK classes in the class table of a CNN
+     * @param classTable Class table
+     * @param classes OK classes of a ROI
+     * @return Flag per class index, true for an OK class
+     */
+    static QVector<bool> okClasses(const CnnClassTable& classTable, const QStringList& classes);
+
+    /**
+     * @brief Getter for the descriptor of an activated CNN
+     * @param cnnData Activated CNN
+     * @return Cached descriptor, it is only rebuilt if the CNN changed
+     *
+     * Throws a std::runtime_error if the CNN is not suited for classification.
+     */
+    std::shared_ptr<const CnnDescriptor> descriptor(const IDS::NXT::CNNv2::CnnData& cnnData);
+
+    /**
+     * @brief Entry of the active ROI/CNN list together with the configuration it was built from
+     *
+     * On a reconfiguration, the entries of unchanged ROIs are reused instead of building them again.
+     */
+    struct PlanEntry {
+        QVariantMap config;
+        MyVision::RoiCnn roiCnn;
+    };
+
     IDS::NXT::ROIManager _roiManager;
     qint64 _totalCnnMemory = 0;
+    qint64 _neededCnnMemory = 0;
     IDS::NXT::ConfigurableFile _cnnRoiConfigFile;
     IDS::NXT::ConfigurableFile _cnnFile;
     std::atomic_bool _cnnInstallationRunning;
     QStringList _installedCNNs;
     CnnRoiConfig _cnnRoiConfig;
-    MyVision::RoiCnnList _activeRoiCnnList;
+    RcuPointer<const MyVision::RoiCnnList> _activeRoiCnnList;
+    RcuPointer<const SensorAoi> _sensorAoi;
+    QHash<QString, std::shared_ptr<const CnnDescriptor>> _descriptors; // keyed by the CNN name
+    QHash<QString, PlanEntry> _plan; // keyed by the ROI name
+    QVariantMap _planSettings; // settings the plan entries were built with
     std::mutex _updateLock;
+    QHash<QString, float> _cnnMemoryMb; // keyed by the CNN name
+    QTimer _descriptionTimer;
 };
@@ -0,0 +1,220 @@
+#include "evidence.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cmath>
+
+#include "cnnroihandler.h"
+
+static QLoggingCategory lc{"multicnnclassifier.evidence"};
+
+static constexpr size_t EVIDENCE_QUEUE_SIZE = 64;
+static constexpr int EVIDENCE_ENCODERS = 2;
+static constexpr int EVIDENCE_JPEG_QUALITY = 90;
+static constexpr int SEQUENCE_DIGITS = 10;
+
+/**
+ * @brief Replaces the characters which are not safe in file names
+ */
+static QString fileNamePart(const QString& text) {
+    static const QRegularExpression unsafe{QStringLiteral("[^A-Za-z0-9_-]")};
+    return QString(text).replace(unsafe, QStringLiteral("_"));
+}
+
+EvidenceStore::EvidenceStore(const QString& directory, qint64 capacity)
+  : _directory{directory}
+  , _capacity{capacity} {
+    if (!_directory.mkpath(QStringLiteral("."))) {
+        throw std::runtime_error("Can not create evidence directory " + directory.toStdString());
+    }
+
+    // continue the ring of an earlier run, the sequence number in front keeps the writing order
+    const auto files = _directory.entryInfoList(QDir::Files, QDir::Name);
+    for (const auto& file : files) {
+        _files.enqueue(qMakePair(file.fileName(), file.size()));
+        _used += file.size();
+        _sequence = std::max(_sequence, file.fileName().section('_', 0, 0).toULongLong() + 1);
+    }
+    evict();
+}
+
+void EvidenceStore::setCapacity(qint64 capacity) {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    _capacity = capacity;
+    evict();
+}
+
+bool EvidenceStore::write(const QString& name, const QByteArray& data) {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    const auto fileName = QStringLiteral("%1_%2").arg(_sequence++, SEQUENCE_DIGITS, 10, QLatin1Char('0')).arg(name);
+    QFile file(_directory.filePath(fileName));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        qCWarning(lc) << "Can not write evidence" << fileName;
+        file.remove();
+        return false;
+    }
+    file.close();
+
+    _files.enqueue(qMakePair(fileName, static_cast<qint64>(data.size())));
+    _used += data.size();
+    evict();
+
+    return true;
+}
+
+void EvidenceStore::evict() {
+    // the newest file is always kept
+    while (_used > _capacity && _files.size() > 1) {
+        const auto oldest = _files.dequeue();
+        _directory.remove(oldest.first);
+        _used -= oldest.second;
+    }
+}
+
+Evidence::Evidence(CnnRoiHandler& cnnRoiHandler)
+  : _cnnRoiHandler{cnnRoiHandler}
+  , _enabled{"evidence", false}
+  , _queue{EVIDENCE_QUEUE_SIZE} {
+    connect(&_enabled, &IDS::NXT::ConfigurableBool::changed, this, &Evidence::enableEvidence);
+    connect(&_cnnRoiHandler, &CnnRoiHandler::activeRoiCnnListChanged, this, &Evidence::activate);
+    activate();
+}
+
+Evidence::~Evidence() {
+    stop();
+}
+
+void Evidence::offer(const QImage& crop, const QString& roiName, const QString& className, double probability) {
+    if (!_running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const auto filter = _filter.load();
+    if (probability >= filter->threshold && !filter->classes.contains(className)) {
+        return;
+    }
+
+    // the crop is shared with the vision object, which detaches it when it cuts out the next image
+    if (!_queue.push(Item{crop, roiName, className, probability})) {
+        _dropped++;
+        return;
+    }
+
+    // an encoder which found the queue empty is either waiting already or sees the crop before it waits
+    {
+        std::lock_guard<std::mutex> locker(_wakeLock);
+    }
+    _itemQueued.notify_one();
+}
+
+QJsonObject Evidence::statistics() {
+    if (!_running) {
+        return {};
+    }
+
+    const auto seconds = static_cast<double>(std::max<qint64>(_statisticsInterval.restart(), 1)) / 1000.;
+    const auto megabytes = static_cast<double>(_bytesWritten.exchange(0)) / 1024. / 1024.;
+    return QJsonObject{{"QueueDepth", static_cast<int>(_queue.size())},
+                       {"Dropped", _dropped.load()},
+                       {"Written", _written.load()},
+                       {"WriteMBps", std::round(megabytes / seconds * 100.) / 100.}};
+}
+
+void Evidence::enableEvidence(bool enable) {
+    stop();
+    if (enable) {
+        try {
+            start();
+        } catch (const std::runtime_error& e) {
+            qCCritical(lc) << "Can not start evidence capture:" << e.what();
+        }
+    }
+}
+
+void Evidence::activate() {
+    const auto settings = _cnnRoiHandler.settings();
+    auto filter = std::make_shared<Filter>();
+    filter->classes = settings.evidenceClasses();
+    filter->threshold = settings.evidenceThreshold();
+    filter->format = settings.evidencePng() ? "PNG" : "JPG";
+    _filter.store(std::move(filter));
+
+    if (_store) {
+        _store->setCapacity(static_cast<qint64>(settings.evidenceSizeMb()) * 1024 * 1024);
+    }
+}
+
+void Evidence::start() {
+    const auto directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                           + QStringLiteral("/evidence");
+    const auto capacity = static_cast<qint64>(_cnnRoiHandler.settings().evidenceSizeMb()) * 1024 * 1024;
+    _store = std::make_unique<EvidenceStore>(directory, capacity);
+    qCDebug(lc) << "Evidence is written to" << directory;
+
+    _dropped = 0;
+    _written = 0;
+    _bytesWritten = 0;
+    _statisticsInterval.start();
+    _stopEncoders = false;
+    for (auto cnt = 0; cnt < EVIDENCE_ENCODERS; cnt++) {
+        _encoders.emplace_back(&Evidence::encode, this);
+    }
+    _running = true;
+}
+
+void Evidence::stop() {
+    _running = false;
+    {
+        std::lock_guard<std::mutex> locker(_wakeLock);
+        _stopEncoders = true;
+    }
+    _itemQueued.notify_all();
+    for (auto& encoder : _encoders) {
+        encoder.join();
+    }
+    _encoders.clear();
+
+    // crops which were not encoded anymore are dropped
+    Item item;
+    while (_queue.pop(item)) {
+        _dropped++;
+    }
+    _store = nullptr;
+}
+
+void Evidence::encode() {
+    Item item;
+    QByteArray data;
+    while (!_stopEncoders) {
+        if (!_queue.pop(item)) {
+            std::unique_lock<std::mutex> locker(_wakeLock);
+            _itemQueued.wait(locker, [this]() { return _stopEncoders || _queue.size() > 0; });
+            continue;
+        }
+
+        const auto filter = _filter.load();
+        data.clear();
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        const auto quality = filter->format == "JPG" ? EVIDENCE_JPEG_QUALITY : -1;
+        if (!item.image.save(&buffer, filter->format.constData(), quality)) {
+            qCWarning(lc) << "Can not encode evidence of" << item.roiName;
+            continue;
+        }
+
+        const auto name = QStringLiteral("%1_%2_%3.%4")
+                              .arg(fileNamePart(item.roiName), fileNamePart(item.className))
+                              .arg(qRound(item.probability * 100), 3, 10, QLatin1Char('0'))
+                              .arg(QString::fromLatin1(filter->format).toLower());
+        if (_store->write(name, data)) {
+            _written++;
+            _bytesWritten += data.size();
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QJsonObject>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QStringList>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <configurablebool.h>
+
+#include "boundedqueue.h"
+#include "rcupointer.h"
+
+class CnnRoiHandler;
+
+/**
+ * @brief Ring-buffered directory of evidence images
+ *
+ * Files are numbered in writing order. When the size cap is exceeded, the oldest files are deleted. Files left by
+ * an earlier run are taken over into the ring.
+ */
+class EvidenceStore {
+public:
+    /**
+     * @brief C'tor
+     * @param directory Directory of the images, it is created if it does not exist
+     * @param capacity Maximum size of all images in bytes
+     * @throw std::runtime_error if the directory can not be created
+     */
+    EvidenceStore(const QString& directory, qint64 capacity);
+
+    /**
+     * @brief Setter for the size cap
+     * @param capacity Maximum size of all images in bytes
+     */
+    void setCapacity(qint64 capacity);
+
+    /**
+     * @brief Writes an image
+     * @param name File name without the sequence number
+     * @param data Encoded image
+     * @return False if the file could not be written
+     */
+    bool write(const QString& name, const QByteArray& data);
+
+private:
+    void evict();
+
+    std::mutex _lock;
+    QDir _directory;
+    qint64 _capacity;
+    qint64 _used = 0;
+    quint64 _sequence = 0;
+    QQueue<QPair<QString, qint64>> _files; // file name and size, oldest first
+};
+
+/**
+ * @brief Saves the CNN inputs of selected ROI results as evidence images
+ *
+ * The engines offer the cut out ROI of every result. Crops which pass the filter on class or confidence are queued
+ * in a bounded lock-free queue and encoded and written by background threads, so the frame path never waits for
+ * the disk. If the queue is full, the crop is dropped and counted.
+ */
+class Evidence : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief C'tor
+     * @param cnnRoiHandler The handler of the ROI/CNN configuration, it provides the filter and the size cap
+     */
+    explicit Evidence(CnnRoiHandler& cnnRoiHandler);
+    ~Evidence() override;
+
+    /**
+     * @brief Offers the crop of a ROI result
+     * @param crop CNN input of the deciding CNN
+     * @param roiName Name of the ROI
+     * @param className Decided class
+     * @param probability Probability of the decided class
+     *
+     * Returns immediately if the evidence capture is switched off or the result does not pass the filter.
+     */
+    void offer(const QImage& crop, const QString& roiName, const QString& className, double probability);
+
+    /**
+     * @brief Takes the figures since the last call
+     * @return Queue depth, dropped and written images and write throughput, empty if switched off
+     */
+    QJsonObject statistics();
+
+private slots:
+    /**
+     * @brief Setter for the evidence capture status
+     * @param enable Flag to start/stop the evidence capture
+     */
+    void enableEvidence(bool enable);
+
+    /**
+     * @brief Takes over the evidence settings of a newly activated configuration
+     */
+    void activate();
+
+private:
+    /**
+     * @brief Queued crop
+     */
+    struct Item {
+        QImage image;
+        QString roiName;
+        QString className;
+        double probability = 0.;
+    };
+
+    /**
+     * @brief Evidence settings of the active configuration
+     */
+    struct Filter {
+        QStringList classes;
+        double threshold = 0.;
+        QByteArray format;
+    };
+
+    void start();
+    void stop();
+    void encode();
+
+    CnnRoiHandler& _cnnRoiHandler;
+    IDS::NXT::ConfigurableBool _enabled;
+    BoundedQueue<Item> _queue;
+    RcuPointer<const Filter> _filter;
+    std::unique_ptr<EvidenceStore> _store;
+    std::vector<std::thread> _encoders;
+    std::atomic_bool _running{false};
+    std::atomic_bool _stopEncoders{false};
+    std::mutex _wakeLock; // only guards the wake-ups of the encoders, the queue itself is lock-free
+    std::condition_variable _itemQueued;
+    std::atomic<qint64> _dropped{0};
+    std::atomic<qint64> _written{0};
+    std::atomic<qint64> _bytesWritten{0};
+    QElapsedTimer _statisticsInterval;
+};
@@ -0,0 +1,206 @@
+#include "imagepreprocessor.h"
+
+#include <QColor>
+#include <QVarLengthArray>
+
+#include <array>
+#include <cstring>
+
+/**
+ * @brief Samples the ROI into the target
+ * @param convert Converts the pixel at a source column of a source line into the target pixel
+ *
+ * Pixel centers of the target are mapped onto the ROI like QImage::scaled() with Qt::FastTransformation does.
+ * Only the sampled pixels of the ROI are read.
+ */
+template <typename TargetPixel, typename Convert>
+static void sample(const QImage& source, const QRect& roi, QImage& target, Convert convert) {
+    const auto width = target.width();
+    const auto height = target.height();
+
+    // The source column of every target column is the same for all lines
+    QVarLengthArray<int, 1024> columns(width);
+    for (auto x = 0; x < width; x++) {
+        columns[x] = roi.x() + ((2 * x + 1) * roi.width()) / (2 * width);
+    }
+
+    for (auto y = 0; y < height; y++) {
+        const auto sourceY = roi.y() + ((2 * y + 1) * roi.height()) / (2 * height);
+        const auto* sourceLine = source.constScanLine(sourceY);
+        auto* targetLine = reinterpret_cast<TargetPixel*>(target.scanLine(y));
+        for (auto x = 0; x < width; x++) {
+            targetLine[x] = convert(sourceLine, columns[x]);
+        }
+    }
+}
+
+/**
+ * @brief Pixel of whole bytes which is copied unchanged
+ */
+template <int BytesPerPixel>
+struct BytePixel {
+    std::array<uchar, BytesPerPixel> bytes;
+};
+
+template <int BytesPerPixel>
+static void sampleBytes(const QImage& source, const QRect& roi, QImage& target) {
+    sample<BytePixel<BytesPerPixel>>(source, roi, target, [](const uchar* line, int x) {
+        BytePixel<BytesPerPixel> pixel;
+        std::memcpy(pixel.bytes.data(), line + x * BytesPerPixel, BytesPerPixel);
+        return pixel;
+    });
+}
+
+/**
+ * @brief Samples 16 bit gray values and reduces them to 8 bit in the same pass
+ *
+ * The values are scaled from the full 16 bit range like QImage::convertToFormat(QImage::Format_Grayscale8) does,
+ * i.e. divided by 257 with rounding. So the result is the same as of the former conversion by QImage, including that
+ * LSB-aligned 10 or 12 bit data remains dark.
+ */
+static void sampleGray16(const QImage& source, const QRect& roi, QImage& target) {
+    sample<uchar>(source, roi, target, [](const uchar* line, int x) {
+        quint16 value;
+        std::memcpy(&value, line + x * 2, sizeof(value));
+        const auto rounded = value + 0x80;
+        return static_cast<uchar>((rounded - (rounded >> 8)) >> 8);
+    });
+}
+
+/**
+ * @brief Samples 32 bit color pixels and packs them to RGB888 in the same pass
+ *
+ * This is the layout the inference takes, so the CNN gets the input without a further conversion. The result matches
+ * QImage::convertToFormat(QImage::Format_RGB888) of the sampled pixels.
+ */
+static void sampleRgb888(const QImage& source, const QRect& roi, QImage& target) {
+    using Rgb = BytePixel<3>;
+
+    switch (source.format()) {
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+        // already in byte order R, G, B, only the 4th byte is dropped
+        sample<Rgb>(source, roi, target, [](const uchar* line, int x) {
+            Rgb pixel;
+            std::memcpy(pixel.bytes.data(), line + x * 4, 3);
+            return pixel;
+        });
+        break;
+    case QImage::Format_ARGB32_Premultiplied:
+        sample<Rgb>(source, roi, target, [](const uchar* line, int x) {
+            QRgb value;
+            std::memcpy(&value, line + x * 4, sizeof(value));
+            value = qUnpremultiply(value);
+            return Rgb{{static_cast<uchar>(qRed(value)), static_cast<uchar>(qGreen(value)),
+                        static_cast<uchar>(qBlue(value))}};
+        });
+        break;
+    default:
+        sample<Rgb>(source, roi, target, [](const uchar* line, int x) {
+            QRgb value;
+            std::memcpy(&value, line + x * 4, sizeof(value));
+            return Rgb{{static_cast<uchar>(qRed(value)), static_cast<uchar>(qGreen(value)),
+                        static_cast<uchar>(qBlue(value))}};
+        });
+        break;
+    }
+}
+
+/**
+ * @brief Samples 1 bit images and expands them to 8 bit gray values in the same pass
+ */
+static void sampleMono(const QImage& source, const QRect& roi, QImage& target) {
+    // the gray values of both color table entries
+    const auto colorTable = source.colorTable();
+    const std::array<uchar, 2> gray{
+        static_cast<uchar>(colorTable.size() > 0 ? qGray(colorTable.at(0)) : 0),
+        static_cast<uchar>(colorTable.size() > 1 ? qGray(colorTable.at(1)) : 255)};
+
+    if (source.format() == QImage::Format_MonoLSB) {
+        sample<uchar>(source, roi, target, [&gray](const uchar* line, int x) {
+            return gray[(line[x >> 3] >> (x & 7)) & 1];
+        });
+    } else {
+        sample<uchar>(source, roi, target, [&gray](const uchar* line, int x) {
+            return gray[(line[x >> 3] >> (7 - (x & 7))) & 1];
+        });
+    }
+}
+
+void ImagePreprocessor::cropAndScale(const QImage& source, const QRect& roi, QImage& target) {
+    const auto size = target.size();
+    if (!isSupported(source.format()) || !source.rect().contains(roi) || roi.isEmpty() || size.isEmpty()) {
+        target = source.copy(roi).scaled(size);
+        return;
+    }
+
+    const auto format = targetFormat(source.format());
+    if (target.format() != format) {
+        target = QImage(size, format);
+    }
+    if (format == QImage::Format_Indexed8) {
+        target.setColorTable(source.colorTable());
+    }
+
+    switch (source.format()) {
+    case QImage::Format_Mono:
+    case QImage::Format_MonoLSB:
+        sampleMono(source, roi, target);
+        break;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    case QImage::Format_Grayscale16:
+        sampleGray16(source, roi, target);
+        break;
+#endif
+    case QImage::Format_Grayscale8:
+    case QImage::Format_Indexed8:
+        sampleBytes<1>(source, roi, target);
+        break;
+    case QImage::Format_RGB888:
+        sampleBytes<3>(source, roi, target);
+        break;
+    default:
+        sampleRgb888(source, roi, target);
+        break;
+    }
+}
+
+QImage::Format ImagePreprocessor::targetFormat(QImage::Format sourceFormat) {
+    switch (sourceFormat) {
+    case QImage::Format_Mono:
+    case QImage::Format_MonoLSB:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    case QImage::Format_Grayscale16:
+#endif
+        return QImage::Format_Grayscale8;
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+        return QImage::Format_RGB888;
+    default:
+        return sourceFormat;
+    }
+}
+
+bool ImagePreprocessor::isSupported(QImage::Format format) {
+    switch (format) {
+    case QImage::Format_Mono:
+    case QImage::Format_MonoLSB:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    case QImage::Format_Grayscale16:
+#endif
+    case QImage::Format_Grayscale8:
+    case QImage::Format_Indexed8:
+    case QImage::Format_RGB888:
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+        return true;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QImage>
+#include <QRect>
+
+/**
+ * @brief Cuts out ROIs and scales them to the CNN input size
+ *
+ * In contrast to QImage::copy() followed by QImage::scaled(), the ROI is sampled in one pass directly into a
+ * target image which is allocated only once and then reused frame by frame. The sampling works on the scanlines
+ * of the image as delivered by the framework. Pixel formats which the CNN can not take directly (1 bit and 16 bit
+ * gray) are converted in the same pass, so only the sampled pixels of the ROI are converted. 32 bit color images
+ * are packed to RGB888 while sampling as well. The target images are in the layout the inference takes, so
+ * CnnData::processImage() does not have to convert them again.
+ */
+class ImagePreprocessor {
+public:
+    /**
+     * @brief Crops and scales a ROI with nearest neighbor sampling
+     * @param source Full image
+     * @param roi ROI inside of the full image
+     * @param target Target image, its size defines the output size. It is reallocated only if its format does not
+     * match targetFormat() of the source.
+     */
+    static void cropAndScale(const QImage& source, const QRect& roi, QImage& target);
+
+    /**
+     * @brief Getter for the format of the cropped images
+     * @param sourceFormat Format of the full image
+     * @return Format of the target image
+     */
+    static QImage::Format targetFormat(QImage::Format sourceFormat);
+
+    /**
+     * @brief Checks if an image format is supported by the one-pass sampling
+     * @param format Image format
+     * @return True if supported, other formats take the QImage::copy() and QImage::scaled() path
+     */
+    static bool isSupported(QImage::Format format);
+};
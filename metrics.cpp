@@ -0,0 +1,157 @@
+#include "metrics.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr int TIME_SAMPLES = 1024;
+
+/**
+ * @brief Ratio of two counts
+ * @return Ratio, 0 if the divisor is 0
+ */
+static double ratio(qint64 count, qint64 total) {
+    return total > 0 ? static_cast<double>(count) / static_cast<double>(total) : 0.;
+}
+
+/**
+ * @brief Rounds a figure to two decimals for the JSON output
+ */
+static double round2(double value) {
+    return std::round(value * 100.) / 100.;
+}
+
+Metrics::Metrics() {
+    _interval.start();
+}
+
+void Metrics::setEnabled(bool enabled) {
+    _enabled = enabled;
+}
+
+bool Metrics::enabled() const {
+    return _enabled;
+}
+
+void Metrics::addFrame(const FrameSample& sample) {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    for (const auto& roiSample : sample.rois) {
+        auto& roi = _rois[roiSample.roi];
+        if (roiSample.skipped) {
+            roi.intervalSkipped++;
+            continue;
+        }
+        if (roi.timesUs.size() < TIME_SAMPLES) {
+            roi.timesUs.append(roiSample.processingTimeUs);
+        } else {
+            roi.timesSumUs -= roi.timesUs[roi.timesPos];
+            roi.timesUs[roi.timesPos] = roiSample.processingTimeUs;
+            roi.timesPos = (roi.timesPos + 1) % TIME_SAMPLES;
+        }
+        roi.timesSumUs += roiSample.processingTimeUs;
+        roi.intervalEvaluated++;
+
+        _intervalRoiEvaluations++;
+        if (roiSample.cascadeExit) {
+            _intervalCascadeExits++;
+        }
+    }
+    for (const auto& cnn : sample.inferences) {
+        _intervalInferences[cnn]++;
+    }
+}
+
+void Metrics::addDroppedFrame() {
+    _droppedFrames++;
+}
+
+void Metrics::addVision(bool prepared) {
+    if (prepared) {
+        _preparedVisions++;
+    } else {
+        _createdVisions++;
+    }
+}
+
+void Metrics::addVisionsInFlight(int delta) {
+    _visionsInFlight += delta;
+}
+
+int Metrics::visionsInFlight() const {
+    return _visionsInFlight;
+}
+
+void Metrics::snapshot(qint64 cnnMemoryHeadroomMb, const QJsonObject& evidence) {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    const auto intervalMs = _interval.restart();
+    const auto seconds = static_cast<double>(std::max<qint64>(intervalMs, 1)) / 1000.;
+
+    QJsonObject cnns;
+    for (auto iter = _intervalInferences.constBegin(); iter != _intervalInferences.constEnd(); ++iter) {
+        cnns.insert(iter.key(), QJsonObject{{"InferencesPerSecond", round2(iter.value() / seconds)}});
+    }
+
+    QJsonObject rois;
+    QVector<qint64> times;
+    for (auto iter = _rois.begin(); iter != _rois.end(); ++iter) {
+        auto& roi = iter.value();
+        // mean and percentile are taken over the same ring of samples
+        times = roi.timesUs;
+        auto p99Us = 0.;
+        if (!times.isEmpty()) {
+            const auto p99 = times.begin() + (times.size() * 99) / 100;
+            std::nth_element(times.begin(), p99, times.end());
+            p99Us = static_cast<double>(*p99);
+        }
+        const auto total = roi.intervalEvaluated + roi.intervalSkipped;
+        rois.insert(iter.key(),
+                    QJsonObject{{"MeanMs", round2(ratio(roi.timesSumUs, times.size()) / 1000.)},
+                                {"P99Ms", round2(p99Us / 1000.)},
+                                {"SkipRatio", round2(ratio(roi.intervalSkipped, total))}});
+
+        roi.intervalEvaluated = 0;
+        roi.intervalSkipped = 0;
+    }
+
+    const qint64 prepared = _preparedVisions;
+    const qint64 created = _createdVisions;
+    QJsonObject metrics{{"IntervalMs", intervalMs},
+                        {"Cnns", cnns},
+                        {"Rois", rois},
+                        {"CascadeExitRatio", round2(ratio(_intervalCascadeExits, _intervalRoiEvaluations))},
+                        {"VisionPoolHitRatio", round2(ratio(prepared, prepared + created))},
+                        {"VisionsInFlight", _visionsInFlight.load()},
+                        {"DroppedFrames", _droppedFrames.load()},
+                        {"CnnMemoryHeadroomMB", cnnMemoryHeadroomMb}};
+    if (!evidence.isEmpty()) {
+        metrics.insert("Evidence", evidence);
+    }
+    _snapshot = QJsonDocument(metrics).toJson(QJsonDocument::Compact);
+
+    _intervalInferences.clear();
+    _intervalRoiEvaluations = 0;
+    _intervalCascadeExits = 0;
+}
+
+QByteArray Metrics::takeSnapshot() {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    QByteArray snapshot;
+    std::swap(snapshot, _snapshot);
+    return snapshot;
+}
+
+void Metrics::reset() {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    _rois.clear();
+    _intervalInferences.clear();
+    _intervalRoiEvaluations = 0;
+    _intervalCascadeExits = 0;
+    _interval.restart();
+    _snapshot.clear();
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * @brief Throughput and health metrics of the vision app
+ *
+ * The engines add the figures of every frame with a single call from their result handling, the vision objects
+ * are not involved. A timer takes a snapshot in regular intervals, which is published with the next image as
+ * JSON. Times are kept in a ring of the latest samples per ROI, so the mean and the percentiles follow the current
+ * load over the same window.
+ */
+class Metrics {
+public:
+    /**
+     * @brief Figures of one ROI in one frame
+     */
+    struct RoiSample {
+        QString roi;
+        qint64 processingTimeUs = 0; // time of all CNNs of the ROI, 0 if skipped
+        bool skipped = false;
+        bool cascadeExit = false; // a cascade stage decided, the CNN of the ROI was not evaluated
+    };
+
+    /**
+     * @brief Figures of one engine in one frame
+     */
+    struct FrameSample {
+        QVector<RoiSample> rois;
+        QVector<QString> inferences; // every evaluated CNN, once per inference
+    };
+
+    Metrics();
+
+    /**
+     * @brief Switches the collection of the frame figures on or off
+     * @param enabled True if the metrics are published
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Getter for the collection of the frame figures
+     * @return True if the engines have to add their frames
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Adds the figures of a frame
+     * @param sample Figures of the frame
+     */
+    void addFrame(const FrameSample& sample);
+
+    /**
+     * @brief Counts a frame which was dropped before all engines finished it
+     */
+    void addDroppedFrame();
+
+    /**
+     * @brief Counts a vision object handed out to the framework
+     * @param prepared True if it was prepared on activation, false if it had to be created on demand
+     */
+    void addVision(bool prepared);
+
+    /**
+     * @brief Counts a vision object starting or finishing an image
+     * @param delta 1 when a vision object is set up, -1 when its result is handled
+     */
+    void addVisionsInFlight(int delta);
+
+    /**
+     * @brief Getter for the vision objects processing an image
+     * @return Number of vision objects in flight
+     */
+    int visionsInFlight() const;
+
+    /**
+     * @brief Takes a snapshot of the metrics since the last snapshot
+     * @param cnnMemoryHeadroomMb Free CNN memory in MB
+     * @param evidence Figures of the evidence capture, empty if it is switched off
+     */
+    void snapshot(qint64 cnnMemoryHeadroomMb, const QJsonObject& evidence = {});
+
+    /**
+     * @brief Takes the latest snapshot for publishing
+     * @return JSON snapshot, empty if there is no new snapshot since the last call
+     */
+    QByteArray takeSnapshot();
+
+    /**
+     * @brief Resets all figures, e.g. after a new configuration was activated
+     */
+    void reset();
+
+private:
+    /**
+     * @brief Figures of a ROI
+     */
+    struct RoiMetrics {
+        QVector<qint64> timesUs; // ring of the latest processing times
+        int timesPos = 0;
+        qint64 timesSumUs = 0; // sum of the ring
+        qint64 intervalEvaluated = 0;
+        qint64 intervalSkipped = 0;
+    };
+
+    std::mutex _lock;
+    QHash<QString, RoiMetrics> _rois;
+    QHash<QString, qint64> _intervalInferences;
+    qint64 _intervalRoiEvaluations = 0;
+    qint64 _intervalCascadeExits = 0;
+    QElapsedTimer _interval;
+    QByteArray _snapshot;
+
+    std::atomic_bool _enabled{false};
+    std::atomic<qint64> _droppedFrames{0};
+    std::atomic<qint64> _preparedVisions{0};
+    std::atomic<qint64> _createdVisions{0};
+    std::atomic_int _visionsInFlight{0};
+};
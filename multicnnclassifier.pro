@@ -10,14 +10,50 @@ SOURCES += main.cpp \
     myengine.cpp \
     cnnroiconfig.cpp \
     cnnroihandler.cpp \
-    myresultimage.cpp
+    myresultimage.cpp \
+    cnnclasstable.cpp \
+    cnndescriptor.cpp \
+    imagepreprocessor.cpp \
+    softmax.cpp \
+    temporalfilter.cpp \
+    outputformat.cpp \
+    resultmerger.cpp \
+    metrics.cpp \
+    overloadcontroller.cpp \
+    trace.cpp \
+    capture.cpp \
+    sensoraoi.cpp \
+    cameramodel.cpp \
+    evidence.cpp \
+    verdict.cpp \
+    benchmark.cpp \
+    workerpool.cpp
 
 HEADERS += myapp.h \
     myvision.h \
     myengine.h \
     cnnroiconfig.h \
     cnnroihandler.h \
-    myresultimage.h
+    myresultimage.h \
+    cnnclasstable.h \
+    cnndescriptor.h \
+    imagepreprocessor.h \
+    softmax.h \
+    temporalfilter.h \
+    outputformat.h \
+    resultmerger.h \
+    metrics.h \
+    overloadcontroller.h \
+    trace.h \
+    capture.h \
+    sensoraoi.h \
+    cameramodel.h \
+    boundedqueue.h \
+    evidence.h \
+    verdict.h \
+    benchmark.h \
+    rcupointer.h \
+    workerpool.h
 
 DEFINES +=
 DISTFILES += README.md
@@ -3,6 +3,8 @@
 #include <QFontDatabase>
 #include <QLoggingCategory>
 
+#include <algorithm>
+
 static QLoggingCategory lc{"multicnnclassifier.app"};
 
 using namespace IDS::NXT::CNNv2;
@@ -10,20 +12,51 @@ using namespace IDS::NXT;
 
 MyApp::MyApp(int& argc, char** argv)
   : IDS::NXT::VApp{argc, argv}
-  , _engine{_resultcollection} {
+  , _resultMerger{_resultcollection, _metrics, _overloadController}
+  , _capture{_cnnRoiHandler}
+  , _evidence{_cnnRoiHandler}
+  , _benchmark{_cnnRoiHandler} {
     // Enable the Deep Ocean Core to load multiple CNNs simultaniously
     CnnManager::getInstance().enableLoadingMultipleCnns(true);
 
     // Create our result source collection
     _resultcollection.createSource("data", IDS::NXT::ResultType::String);
+    _resultcollection.createSource("deadlinemisses", IDS::NXT::ResultType::String);
+    _resultcollection.createSource("imageholdtime", IDS::NXT::ResultType::String);
+    _resultcollection.createSource("metrics", IDS::NXT::ResultType::String);
+    _resultcollection.createSource("overload", IDS::NXT::ResultType::String);
+    _resultcollection.createSource("okmask", IDS::NXT::ResultType::String);
+    _resultcollection.createSource("verdict", IDS::NXT::ResultType::String);
 
     // Load the font for our result image
     QFontDatabase::addApplicationFont(VApp::vappAppDirectory() + "DejaVuSans.ttf");
+
+    connect(&_metricsTimer, &QTimer::timeout, this, &MyApp::updateMetrics);
+    connect(&_resultMerger, &ResultMerger::deadlineMissed, &_traceRecorder, &TraceRecorder::deadlineMissed);
+    connect(&_cnnRoiHandler, &CnnRoiHandler::activeRoiCnnListChanged, this, &MyApp::activate);
+    activate();
 }
 
 void MyApp::imageAvailable(std::shared_ptr<IDS::NXT::Hardware::Image> image) {
-    if (_engine.isInitialized()) {
-        _engine.handleImage(image);
+    Trace::Span span("imageAvailable");
+
+    if (!_retiredEngines.empty()) {
+        removeIdleEngines();
+    }
+
+    QList<MyEngine*> engines;
+    for (const auto& engine : _engines) {
+        if (engine->isInitialized()) {
+            engines.append(engine.get());
+        }
+    }
+
+    if (!engines.isEmpty()) {
+        // Announce the image first, the results of the engines are merged into one finishedAllParts
+        _resultMerger.expect(image, engines.size());
+        for (auto* engine : qAsConst(engines)) {
+            engine->handleImage(image);
+        }
     } else {
         _resultcollection.addResult("data",
                                     QStringLiteral("No CNN/ROI configuration set"),
@@ -37,5 +70,66 @@ void MyApp::imageAvailable(std::shared_ptr<IDS::NXT::Hardware::Image> image) {
 }
 
 void MyApp::abortVision() {
-    _engine.abortVision();
+    for (const auto& engine : _engines) {
+        engine->abortVision();
+    }
+}
+
+void MyApp::activate() {
+    const auto settings = _cnnRoiHandler.settings();
+    // the engines of removed shards stop at once, they are destroyed when their images are finished
+    while (static_cast<int>(_engines.size()) > settings.shards()) {
+        qCDebug(lc) << "Retire engine of shard" << _engines.size() - 1;
+        _engines.back()->abortVision();
+        _retiredEngines.push_back(std::move(_engines.back()));
+        _engines.pop_back();
+    }
+    removeIdleEngines();
+
+    while (static_cast<int>(_engines.size()) < settings.shards()) {
+        const auto shard = static_cast<int>(_engines.size());
+        qCDebug(lc) << "Create engine for shard" << shard;
+        _engines.push_back(std::make_unique<MyEngine>(_resultcollection,
+                                                      _cnnRoiHandler,
+                                                      _resultMerger,
+                                                      _metrics,
+                                                      _capture,
+                                                      _overloadController,
+                                                      _evidence,
+                                                      shard));
+    }
+
+    // the figures of the previous configuration do not apply anymore
+    _metrics.reset();
+    _metrics.setEnabled(settings.metricsIntervalMs() > 0);
+    if (settings.metricsIntervalMs() > 0) {
+        _metricsTimer.start(settings.metricsIntervalMs());
+    } else {
+        _metricsTimer.stop();
+    }
+
+    // images queue up once more vision objects are in flight than the engines keep prepared
+    _overloadController.configure(settings.overloadLatencyMs(),
+                                  settings.overloadSubsample(),
+                                  std::max(settings.visionPoolSize(), 1) * settings.shards());
+
+    // only the ROIs which are active take part in the verdict
+    quint32 verdictRois = 0;
+    for (const auto& roiCnn : *_cnnRoiHandler.activeRoiCnnList()) {
+        if (roiCnn.verdictBit >= 0) {
+            verdictRois |= 1u << roiCnn.verdictBit;
+        }
+    }
+    _resultMerger.setVerdictRule(VerdictRule(settings.verdict(), settings.verdictMinOk(), verdictRois));
+}
+
+void MyApp::removeIdleEngines() {
+    _retiredEngines.erase(std::remove_if(_retiredEngines.begin(),
+                                         _retiredEngines.end(),
+                                         [](const std::unique_ptr<MyEngine>& engine) { return engine->isIdle(); }),
+                          _retiredEngines.end());
+}
+
+void MyApp::updateMetrics() {
+    _metrics.snapshot(_cnnRoiHandler.cnnMemoryHeadroom(), _evidence.statistics());
 }
@@ -6,7 +6,20 @@
 #include <vapp.h>
 
 // Include own headers
+#include "benchmark.h"
+#include "capture.h"
+#include "cnnroihandler.h"
+#include "evidence.h"
+#include "metrics.h"
 #include "myengine.h"
+#include "overloadcontroller.h"
+#include "resultmerger.h"
+#include "trace.h"
+
+#include <QTimer>
+
+#include <memory>
+#include <vector>
 
 /**
  * @brief The app-specific app object
@@ -48,8 +61,27 @@ protected slots:
     void abortVision() override;
 
 private slots:
+    /**
+     * @brief Takes over the settings of a newly activated ROI/CNN list
+     *
+     * Creates the engines for the number of shards. The engines of shards which are not configured anymore are
+     * aborted and do not get images anymore, they are destroyed as soon as they finished the images of the previous
+     * configuration. Engines without ROIs do not get any images. Restarts the metrics with the configured interval
+     * and the overload control in normal mode.
+     */
+    void activate();
+
+    /**
+     * @brief Takes a snapshot of the metrics, it is published with the next image
+     */
+    void updateMetrics();
 
 private:
+    /**
+     * @brief Destroys the retired engines which finished all their images
+     */
+    void removeIdleEngines();
+
     /**
      * @brief Collection of results
      *
@@ -58,7 +90,27 @@ private:
      */
     IDS::NXT::ResultSourceCollection _resultcollection;
 
-    MyEngine _engine;
+    CnnRoiHandler _cnnRoiHandler;
+    Metrics _metrics;
+    QTimer _metricsTimer;
+    OverloadController _overloadController;
+    ResultMerger _resultMerger;
+    TraceRecorder _traceRecorder;
+    Capture _capture;
+    Evidence _evidence;
+    Benchmark _benchmark;
+
+    /**
+     * @brief Engines, one per shard
+     *
+     * The ROIs are split across the engines, so the pre- and post-processing of a frame can run on several cores.
+     */
+    std::vector<std::unique_ptr<MyEngine>> _engines;
+
+    /**
+     * @brief Engines of removed shards which may still process images of the previous configuration
+     */
+    std::vector<std::unique_ptr<MyEngine>> _retiredEngines;
 };
 
 #endif // MYAPP_H
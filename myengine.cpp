@@ -1,151 +1,403 @@
 #include "myengine.h"
 
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QLoggingCategory>
 #include <QStringList>
+#include <QThread>
 
-#include <cmath>
+#include <algorithm>
+
+#include "imagepreprocessor.h"
+#include "softmax.h"
+#include "trace.h"
 
 static QLoggingCategory lc{"multicnnclassifier.engine"};
 
 using namespace IDS::NXT;
 using namespace IDS::NXT::CNNv2;
 
-static constexpr int MAX_RESULT_VALUES = 5;
-
-MyEngine::MyEngine(IDS::NXT::ResultSourceCollection& resultcollection)
+MyEngine::MyEngine(IDS::NXT::ResultSourceCollection& resultcollection,
+                   CnnRoiHandler& cnnRoiHandler,
+                   ResultMerger& resultMerger,
+                   Metrics& metrics,
+                   Capture& capture,
+                   OverloadController& overloadController,
+                   Evidence& evidence,
+                   int shard)
   : _resultCollection{resultcollection}
-  , _createResultImage{"createresultimage", false}
-  , _resultImage{nullptr} {
-    // connect configurable bool (switch) changed-event
-    connect(&_createResultImage, &IDS::NXT::ConfigurableBool::changed, this, &MyEngine::enableResultImage);
+  , _cnnRoiHandler{cnnRoiHandler}
+  , _resultMerger{resultMerger}
+  , _metrics{metrics}
+  , _capture{capture}
+  , _overloadController{overloadController}
+  , _evidence{evidence}
+  , _shard{shard}
+  , _sourceFormat{QImage::Format_RGB888}
+  , _frameBudgetMs{0}
+  , _cpuCore{-1}
+  , _publishOnChange{false}
+  , _heartbeatMs{0}
+  , _resetRoiStates{false}
+  , _frameCounter{0}
+  , _visionsInFlight{0} {
+    _publishClock.start();
+
+    connect(&_cnnRoiHandler, &CnnRoiHandler::activeRoiCnnListChanged, this, &MyEngine::activate);
+    connect(&_cnnRoiHandler, &CnnRoiHandler::activeRoisMoved, this, &MyEngine::takeOverShardRois);
+    activate();
 }
 
 bool MyEngine::isInitialized() const {
-    return !_cnnRoiHandler.activeRoiCnnList().isEmpty();
+    return !roiCnnList()->isEmpty();
+}
+
+bool MyEngine::isIdle() const {
+    return _visionsInFlight == 0;
+}
+
+MyVision::RoiCnnListPtr MyEngine::roiCnnList() const {
+    return _roiCnnList.load();
 }
 
 std::shared_ptr<IDS::NXT::Vision> MyEngine::factoryVision() {
+    // Hand out the vision objects prepared on activation first
+    {
+        std::lock_guard<std::mutex> locker(_visionPoolLock);
+        if (!_visionPool.empty()) {
+            auto vision = _visionPool.back();
+            _visionPool.pop_back();
+            _metrics.addVision(true);
+            return vision;
+        }
+    }
+    _metrics.addVision(false);
+
     // Simply construct a vision object, we may give further parameters, such as not-changing
     // parameters or shared (thread-safe!) objects.
     return std::make_shared<MyVision>();
 }
 
 void MyEngine::setupVision(std::shared_ptr<IDS::NXT::Vision> vision) {
+    Trace::Span span("setupVision");
+
     // Here we could set changing parameters, such as current configurable values
     if (vision) {
         auto obj = std::static_pointer_cast<MyVision>(vision);
 
         // set current activated CNNs because they could change during runtime.
-        obj->setCnnData(_cnnRoiHandler.activeRoiCnnList());
+        obj->setCnnData(roiCnnList(), static_cast<QImage::Format>(_sourceFormat.load()));
+        obj->setFrameBudget(_frameBudgetMs);
+        obj->setCpuCore(_cpuCore);
+        obj->setSensorAoi(_cnnRoiHandler.sensorAoi());
+        // under overload, the result image is dropped first and then the ROIs which are not critical are subsampled
+        const auto subsample = static_cast<unsigned>(_overloadController.subsample());
+        obj->setEvaluateNonCritical(_frameCounter++ % subsample == 0);
+        obj->setCopyImage(_resultMerger.resultImageEnabled()
+                          && _overloadController.mode() == OverloadController::Mode::Normal);
+        obj->setCaptureWriter(_capture.writer());
+        obj->setResultMerger(&_resultMerger);
+        _metrics.addVisionsInFlight(1);
+        _visionsInFlight++;
     }
 }
 
 void MyEngine::handleResult(std::shared_ptr<IDS::NXT::Vision> vision) {
+    Trace::Span span("handleResult");
+
     // Get the finished vision object
     const auto obj = std::static_pointer_cast<MyVision>(vision);
+    const auto visionsInFlight = _metrics.visionsInFlight();
+    _metrics.addVisionsInFlight(-1);
 
+    // The vision object released the image as soon as the ROIs were cut out, if the processing did not fail
+    // before. The results are published on the image held by the merger until all parts are finished.
+    obj->setImage(nullptr);
+    const auto image = _resultMerger.pendingImage(obj->processedImage());
+    if (!image) {
+        qCWarning(lc) << "Result for an image which was not announced";
+        _visionsInFlight--;
+        return;
+    }
+
+    ResultMerger::Part part;
+    // the figures of the frame are only collected if the metrics are published
+    const auto collectMetrics = _metrics.enabled();
+    Metrics::FrameSample metricsSample;
     try {
+        // the temporal state of the previous configuration does not apply anymore
+        if (_resetRoiStates.exchange(false)) {
+            _roiStates.clear();
+        }
+
         // extracting the inference result of the CNN ...
-        const auto allResults = obj->result();
+        const auto roiCnnList = obj->roiCnnList();
+        const auto roiCount = roiCnnList ? roiCnnList->size() : 0;
+        if (obj->finishedResults() != roiCount) {
+            qCDebug(lc) << "Only" << obj->finishedResults() << "of" << roiCount << "ROIs finished";
+        }
 
-        QList<MyResultImage::overlayData> drawData;
-        if (_resultImage) {
-            drawData.reserve(static_cast<size_t>(allResults.size()));
+        const auto createOverlay = _resultMerger.resultImageEnabled() && !obj->imageCopy().isNull();
+        if (createOverlay) {
+            part.overlay.reserve(roiCount);
         }
 
-        for (const auto& oneResult : allResults) {
-            const auto& cnnDataStruct = oneResult.first;
-            const auto& thisCnnResult = oneResult.second;
-            const auto& cnnData = cnnDataStruct.cnnData;
-            const std::unique_ptr<IDS::NXT::CNNv2::MultiBuffer>& cnnResult = thisCnnResult;
+        for (auto index = 0; index < roiCount; index++) {
+            const auto& oneResult = obj->result(index);
+            // subsampled ROIs keep their last published result
+            if (oneResult.subsampled) {
+                continue;
+            }
+            const auto& cnnDataStruct = roiCnnList->at(index);
+
+            // a ROI which is part of the verdict and did not decide counts as NOK
+            const auto verdictBit = cnnDataStruct.verdictBit >= 0 ? 1u << cnnDataStruct.verdictBit : 0u;
+            part.verdictRois |= verdictBit;
+
+            // Every CNN which can decide the ROI has its own temporal state, their classes do not correspond. A
+            // vision object may still deliver a result of the previous list after the reset, so a state built for
+            // another number of stages is replaced instead of being indexed out of range.
+            const auto filterCount = cnnDataStruct.cascade.size() + 1;
+            auto roiStateIter = _roiStates.find(cnnDataStruct.roiName);
+            if (roiStateIter == _roiStates.end() || roiStateIter->filters.size() != filterCount) {
+                roiStateIter = _roiStates.insert(
+                    cnnDataStruct.roiName,
+                    RoiState{QVector<TemporalFilter>(filterCount, TemporalFilter{cnnDataStruct.smoothing})});
+            }
+            auto& roiState = *roiStateIter;
+            const auto now = _publishClock.elapsed();
+            const auto heartbeat = _heartbeatMs > 0 && now - roiState.publishedTime >= _heartbeatMs;
+
+            // a ROI whose evaluation did not finish is reported as error in every publish mode
+            if (!oneResult.done) {
+                QByteArray thisJsonResult = cnnDataStruct.jsonPrefix;
+                thisJsonResult.append("\"error\"");
+                if (!obj->error().isEmpty()) {
+                    thisJsonResult.append(",\"Error\":");
+                    thisJsonResult.append(CnnClassTable::jsonString(obj->error()));
+                }
+                thisJsonResult.append('}');
+                _resultCollection.addResult("data", thisJsonResult, cnnDataStruct.roiName, image);
+                roiState.publishedDecision = -1;
+                roiState.publishedSkipped = false;
+                roiState.publishedTime = now;
+                continue;
+            }
+            if (collectMetrics) {
+                metricsSample.rois.append(Metrics::RoiSample{cnnDataStruct.roiName,
+                                                             oneResult.processingTimeUs,
+                                                             oneResult.skipped,
+                                                             oneResult.cascadeStage >= 0});
+            }
+
+            // report the ROIs which did not fit into the frame budget, in publish on change mode only once
+            if (oneResult.skipped) {
+                part.skippedRois++;
+                if (!_publishOnChange || !roiState.publishedSkipped || heartbeat) {
+                    QByteArray thisJsonResult = cnnDataStruct.jsonPrefix;
+                    thisJsonResult.append("\"not evaluated\"}");
+                    _resultCollection.addResult("data", thisJsonResult, cnnDataStruct.roiName, image);
+                    roiState.publishedSkipped = true;
+                    roiState.publishedTime = now;
+                }
+                continue;
+            }
+
+            // a confident cascade stage reports its own CNN
+            const auto* stage = oneResult.cascadeStage >= 0 ? &cnnDataStruct.cascade.at(oneResult.cascadeStage)
+                                                            : nullptr;
+            const auto& thisCnnResults = oneResult.outputs;
+            const auto& classTablePtr = stage ? stage->descriptor->classTable()
+                                              : cnnDataStruct.descriptor->classTable();
+            const auto& jsonPrefix = stage ? stage->jsonPrefix : cnnDataStruct.jsonPrefix;
 
-            // Get the output buffers of the CNN
-            const auto& allBuffers = cnnResult->allBuffers();
+            // the cascade stages up to the deciding one ran, the CNN and the ensemble only if no stage decided
+            if (collectMetrics) {
+                const auto stagesRun = stage ? oneResult.cascadeStage + 1 : cnnDataStruct.cascade.size();
+                for (auto stageCnt = 0; stageCnt < stagesRun; stageCnt++) {
+                    metricsSample.inferences.append(cnnDataStruct.cascade.at(stageCnt).descriptor->name());
+                }
+                if (!stage) {
+                    metricsSample.inferences.append(cnnDataStruct.descriptor->name());
+                    for (const auto& member : cnnDataStruct.ensembleDescriptors) {
+                        metricsSample.inferences.append(member->name());
+                    }
+                }
+            }
 
-            // Check if result is suited for classification
-            if (cnnData.inferenceType() != CnnData::InferenceType::Classification || allBuffers.size() != 1) {
-                throw std::runtime_error(
-                    "Error: CNN is not suited for classification or output buffer set is not specified correctly.");
+            // The inference type is validated on activation, only the output buffers are checked per result
+            for (const auto& cnnResult : thisCnnResults) {
+                // Get the output buffers of the CNN
+                if (cnnResult->allBuffers().size() != 1) {
+                    throw std::runtime_error("Error: CNN is not suited for classification or output buffer set is "
+                                             "not specified correctly.");
+                }
             }
 
-            // Convert result to double and map corresponding class;
-            QList<QPair<QString, double>> resultClasses;
-            resultClasses.reserve(cnnData.classes().size());
-            auto expSum = 0.;
-
-            // Classification CNNs have only one output Buffer
-            auto currentCnnOutputBuffer = allBuffers.at(0);
-            for (auto cnt = 0; cnt < cnnData.classes().size(); cnt++) {
-                const auto currentClass = cnnData.classes().at(cnt);
-                // Apply exponential function for softmax calculation;
-                const auto currentVal = std::exp(static_cast<double>(currentCnnOutputBuffer.data[cnt]));
-                // Sum up values for softmax dividor
-                expSum += currentVal;
-                resultClasses.append(qMakePair(currentClass, currentVal));
+            // Convert result to double. Classes are only referenced by their index in the class table.
+            // The kernels specialized for the class count are selected on activation of the CNN
+            const auto& classTable = *classTablePtr;
+            const auto& kernels = stage ? stage->descriptor->kernels() : cnnDataStruct.descriptor->kernels();
+            auto& resultClasses = _resultClasses;
+            auto expSum = 1.;
+            if (thisCnnResults.size() == 1) {
+                expSum = kernels.exponentials(*thisCnnResults.front(),
+                                              classTable.size(),
+                                              resultClasses,
+                                              stage ? stage->outputFormat : cnnDataStruct.outputFormats.value(0));
+            } else if (cnnDataStruct.fusion == CnnRoiConfig::CnnRoiMap::Fusion::Vote) {
+                // the fused values are already probabilities
+                Softmax::vote(thisCnnResults, cnnDataStruct.outputFormats, classTable.size(), resultClasses);
+            } else {
+                Softmax::average(thisCnnResults, cnnDataStruct.outputFormats, classTable.size(), resultClasses);
+            }
+
+            // Temporal filtering works on the probabilities of the frames
+            const auto smoothing = cnnDataStruct.smoothing.mode != CnnRoiConfig::CnnRoiMap::Smoothing::Mode::None;
+            if (smoothing) {
+                for (auto& value : resultClasses) {
+                    value.second /= expSum;
+                }
+                expSum = 1.;
+            }
+            auto& filter = roiState.filters[stage ? oneResult.cascadeStage : cnnDataStruct.cascade.size()];
+            const auto decision = filter.apply(resultClasses);
+            const auto decisionProbability = resultClasses.at(decision).second / expSum;
+            const auto& okClasses = stage ? stage->okClasses : cnnDataStruct.okClasses;
+            if (verdictBit && okClasses.value(decision) && decisionProbability >= cnnDataStruct.okThreshold) {
+                part.okMask |= verdictBit;
             }
 
             // sort classes
-            qSort(resultClasses.begin(), resultClasses.end(), ProbabilityComparer());
-
-            // create result for resultSourceCollection
-            QJsonObject thisJsonResult;
-            thisJsonResult.insert(QStringLiteral("CNN"), cnnData.name());
-            thisJsonResult.insert(QStringLiteral("ROI"), cnnDataStruct.roiName);
-            thisJsonResult.insert(QStringLiteral("Result"), resultToJson(resultClasses, expSum, true));
-            _resultCollection.addResult("data",
-                                        QJsonDocument(thisJsonResult).toJson(QJsonDocument::Compact),
-                                        cnnDataStruct.roiName,
-                                        vision->image());
-
-            // create result image
-            if (_resultImage) {
-                MyResultImage::overlayData overlay;
-                overlay.result = qMakePair(resultClasses.at(0).first, resultClasses.at(0).second / expSum);
-                overlay.roi = cnnDataStruct.roi;
+            kernels.sort(resultClasses);
+
+            // create result for resultSourceCollection, in publish on change mode only for changed decisions
+            if (!_publishOnChange || roiState.publishedSkipped || oneResult.cascadeStage != roiState.publishedStage ||
+                decision != roiState.publishedDecision || heartbeat) {
+                QByteArray thisJsonResult = jsonPrefix;
+                classTable.appendJson(thisJsonResult, resultClasses, expSum, true);
+                if (smoothing) {
+                    thisJsonResult.append(",\"Decision\":");
+                    thisJsonResult.append(classTable.jsonName(decision));
+                }
+                thisJsonResult.append('}');
+                _resultCollection.addResult("data", thisJsonResult, cnnDataStruct.roiName, image);
 
-                drawData.append(overlay);
+                roiState.publishedStage = oneResult.cascadeStage;
+                roiState.publishedDecision = decision;
+                roiState.publishedSkipped = false;
+                roiState.publishedTime = now;
             }
-        }
 
-        if (_resultImage) {
-            _resultImage->setImageWithOverlay(obj->image()->getQImage(), obj->image(), drawData);
+            // the input of the deciding CNN is kept as evidence if the result passes the evidence filter
+            const auto& inputs = obj->inputs(index);
+            _evidence.offer(stage ? inputs.at(oneResult.cascadeStage) : inputs.last(),
+                            cnnDataStruct.roiName,
+                            classTable.name(decision),
+                            decisionProbability);
+
+            // create overlay of the result image
+            if (createOverlay) {
+                MyResultImage::overlayData overlay;
+                overlay.classes = classTablePtr;
+                overlay.classIndex = decision;
+                overlay.probability = static_cast<float>(decisionProbability);
+                overlay.roi = cnnDataStruct.roi.translated(-obj->imageOffset());
+
+                part.overlay.append(overlay);
+            }
         }
     } catch (const std::runtime_error& e) {
         qCCritical(lc) << "Error handling result: " << e.what();
-        _resultCollection.addResult("data", e.what(), QStringLiteral("Content1"), vision->image());
+        _resultCollection.addResult("data", e.what(), QStringLiteral("Content1"), image);
+    }
+    // remember the image format to allocate the input buffers of new vision objects in the right format
+    if (obj->sourceFormat() != QImage::Format_Invalid) {
+        _sourceFormat = obj->sourceFormat();
     }
-    // signal that all parts of the image are finished
-    _resultCollection.finishedAllParts(obj->image());
 
-    // Remove the image pointer from the vision object and thereby allow the framework to
-    // reuse the image buffer.
-    obj->setImage(nullptr);
+    if (collectMetrics) {
+        _metrics.addFrame(metricsSample);
+    }
+    _overloadController.addFrame(obj->processingTimeUs(), visionsInFlight);
+
+    // the image is finished once the engines of all shards are done with it
+    part.shard = _shard;
+    part.image = obj->imageCopy();
+    part.reportDeadlineMisses = _frameBudgetMs > 0;
+    part.imageHoldTimeUs = obj->imageHoldTimeUs();
+    _resultMerger.finishPart(image, part);
+    _visionsInFlight--;
 }
 
-void MyEngine::enableResultImage(bool enable) {
-    if (enable) {
-        _resultImage = std::make_unique<MyResultImage>("resultimage");
-    } else {
-        _resultImage = nullptr;
+void MyEngine::activate() {
+    const auto settings = _cnnRoiHandler.settings();
+    takeOverShardRois();
+
+    // with several shards, every engine keeps its visions on an own core
+    _cpuCore = settings.shards() > 1 ? _shard % QThread::idealThreadCount() : -1;
+    _frameBudgetMs = settings.frameBudgetMs();
+    _publishOnChange = settings.publishOnChange();
+    _heartbeatMs = settings.heartbeatMs();
+    _resetRoiStates = true;
+    warmUp();
+}
+
+void MyEngine::takeOverShardRois() {
+    // the vision objects take over the list on setup, so the prepared ones need not be rebuilt
+    MyVision::RoiCnnList shardList;
+    for (const auto& roiCnn : *_cnnRoiHandler.activeRoiCnnList()) {
+        if (roiCnn.shard == _shard) {
+            shardList.append(roiCnn);
+        }
     }
+    _roiCnnList.store(std::make_shared<const MyVision::RoiCnnList>(std::move(shardList)));
 }
 
-QJsonArray MyEngine::resultToJson(const QList<QPair<QString, double>>& results, double expsum, bool limitResults) {
-    QJsonArray output;
+void MyEngine::warmUp() {
+    const auto roiCnnList = this->roiCnnList();
+    const auto settings = _cnnRoiHandler.settings();
+    const auto format = static_cast<QImage::Format>(_sourceFormat.load());
 
-    auto resultCnt = 0;
-    for (const auto& result : results) {
-        QJsonObject resultJson;
-        resultJson.insert(QStringLiteral("Class"), result.first);
-        resultJson.insert(QStringLiteral("Probability"), QString::number(result.second / expsum, 'f', 2).toDouble());
-        output.append(resultJson);
+    {
+        std::lock_guard<std::mutex> locker(_visionPoolLock);
+        _visionPool.clear();
+        // an engine without ROIs does not get any image
+        const auto visionPoolSize = roiCnnList->isEmpty() ? 0 : settings.visionPoolSize();
+        for (auto cnt = 0; cnt < visionPoolSize; cnt++) {
+            auto vision = std::make_shared<MyVision>();
+            vision->setCnnData(roiCnnList, format);
+            _visionPool.push_back(vision);
+        }
+    }
+
+    if (!settings.warmUp()) {
+        return;
+    }
 
-        if (limitResults && ++resultCnt > MAX_RESULT_VALUES) {
-            break;
+    // The first inference of a CNN is much slower than the following ones, so run it once with a blank image
+    QList<CnnData> cnns;
+    for (const auto& roiCnn : *roiCnnList) {
+        for (const auto& stage : roiCnn.cascade) {
+            cnns.append(stage.cnnData);
         }
+        cnns.append(roiCnn.cnnData);
+        cnns.append(roiCnn.ensemble);
     }
+    // a reconfiguration which only moves ROIs or changes some of them does not warm up the other CNNs again
+    for (auto cnnData : qAsConst(cnns)) {
+        if (_warmedUpCnns.contains(cnnData.name())) {
+            continue;
+        }
+        _warmedUpCnns.append(cnnData.name());
 
-    return output;
+        try {
+            const auto inputFormat = ImagePreprocessor::targetFormat(format);
+            QImage blank(cnnData.inputSize(),
+                         inputFormat == QImage::Format_Indexed8 ? QImage::Format_Grayscale8 : inputFormat);
+            blank.fill(0);
+            cnnData.processImage(blank, QStringLiteral("Classification"));
+            qCDebug(lc) << "Warm-up of" << cnnData.name() << "done";
+        } catch (const std::exception& e) {
+            qCWarning(lc) << "Warm-up of" << cnnData.name() << "failed:" << e.what();
+        }
+    }
 }
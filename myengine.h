@@ -1,15 +1,25 @@
 #pragma once
 
-#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <cnnmanager_v2.h>
-#include <configurablebool.h>
 #include <engine.h>
 #include <resultsourcecollection.h>
 
+#include "capture.h"
 #include "cnnroihandler.h"
-#include "myresultimage.h"
+#include "evidence.h"
+#include "metrics.h"
+#include "overloadcontroller.h"
+#include "rcupointer.h"
+#include "resultmerger.h"
+#include "temporalfilter.h"
 
 /**
  * @brief The app-specific engine
@@ -21,18 +31,38 @@ public:
     /**
      * @brief Constructor
      * @param resultcollection The result collection object
+     * @param cnnRoiHandler The handler of the ROI/CNN configuration shared by all engines
+     * @param resultMerger The merger which finishes the images of all engines
+     * @param metrics The metrics shared by all engines
+     * @param capture The recording of the CNN inputs
+     * @param overloadController The controller which degrades the processing under overload
+     * @param evidence The sink for the crops of selected ROI results
+     * @param shard Index of the engine, it evaluates the ROIs assigned to this shard
      *
      * This function constructs the engine object, further parameters could be inserted if
      * app-global interaction objects should be used in a multi-engine vision app.
      */
-    MyEngine(IDS::NXT::ResultSourceCollection& resultcollection);
+    MyEngine(IDS::NXT::ResultSourceCollection& resultcollection,
+             CnnRoiHandler& cnnRoiHandler,
+             ResultMerger& resultMerger,
+             Metrics& metrics,
+             Capture& capture,
+             OverloadController& overloadController,
+             Evidence& evidence,
+             int shard = 0);
 
     /**
      * @brief Getter for initialization attribute
-     * @return True if CNN/ROI config is set
+     * @return True if ROIs are assigned to this engine
      */
     bool isInitialized() const;
 
+    /**
+     * @brief Getter for the idle state
+     * @return True if no vision object of the engine is processing an image or waiting for its result handling
+     */
+    bool isIdle() const;
+
 protected:
     /**
      * @brief Factory function for vision objects
@@ -67,16 +97,65 @@ protected:
 
 private slots:
     /**
-     * @brief Setter for result image status
-     * @param enable Flag to enable/disable result image
+     * @brief Prepares the engine for a newly activated ROI/CNN list
+     *
+     * Pre-creates the configured number of vision objects including their input buffers and runs one dummy
+     * inference per CNN, so the first real frame does not pay for allocations and the first run of a CNN. CNNs
+     * which were warmed up by an earlier activation are skipped.
+     */
+    void warmUp();
+
+    /**
+     * @brief Takes over the settings and the ROIs of this shard of a newly activated ROI/CNN list
+     */
+    void activate();
+
+    /**
+     * @brief Takes over the ROIs of this shard of the active ROI/CNN list
+     *
+     * Also called alone for moved ROIs, which keep the temporal state and the prepared vision objects.
      */
-    void enableResultImage(bool enable);
+    void takeOverShardRois();
 
 private:
-    QJsonArray resultToJson(const QList<QPair<QString, double>>& results, double expsum, bool limitResults = false);
+    /**
+     * @brief State of a ROI over consecutive frames
+     */
+    struct RoiState {
+        QVector<TemporalFilter> filters; // by deciding CNN, the cascade stages followed by the CNN of the ROI
+        int publishedStage = -1;
+        int publishedDecision = -1;
+        bool publishedSkipped = false;
+        qint64 publishedTime = 0;
+    };
+
+    /**
+     * @brief Getter for the ROIs of this shard
+     * @return Snapshot of the ROI/CNN list of this engine
+     */
+    MyVision::RoiCnnListPtr roiCnnList() const;
 
     IDS::NXT::ResultSourceCollection& _resultCollection;
-    CnnRoiHandler _cnnRoiHandler;
-    IDS::NXT::ConfigurableBool _createResultImage;
-    std::unique_ptr<MyResultImage> _resultImage;
+    CnnRoiHandler& _cnnRoiHandler;
+    ResultMerger& _resultMerger;
+    Metrics& _metrics;
+    Capture& _capture;
+    OverloadController& _overloadController;
+    Evidence& _evidence;
+    const int _shard;
+    RcuPointer<const MyVision::RoiCnnList> _roiCnnList;
+    std::vector<std::shared_ptr<MyVision>> _visionPool;
+    std::mutex _visionPoolLock;
+    std::atomic_int _sourceFormat;
+    std::atomic_int _frameBudgetMs;
+    std::atomic_int _cpuCore;
+    std::atomic_bool _publishOnChange;
+    std::atomic_int _heartbeatMs;
+    std::atomic_bool _resetRoiStates;
+    std::atomic_uint _frameCounter;
+    std::atomic_int _visionsInFlight;
+    QHash<QString, RoiState> _roiStates;
+    Softmax::ClassValues _resultClasses; // reused for every ROI, so the frame path does not allocate
+    QStringList _warmedUpCnns;
+    QElapsedTimer _publishClock;
 };
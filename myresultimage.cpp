@@ -1,8 +1,12 @@
 #include "myresultimage.h"
 
+#include <QFontMetrics>
 #include <QLoggingCategory>
 #include <QPainter>
 #include <QRawFont>
+#include <QVector>
+
+#include "cnnroiconfig.h"
 
 static QLoggingCategory lc{"multicnnclassifier.customresultimage"};
 
@@ -11,6 +15,29 @@ static constexpr int FONT_MINIMAL_PIXEL_SIZE = 5;
 static constexpr int PEN_WIDTH = 3;
 static constexpr float BOX_SCALING_FACTOR = 0.8;
 
+namespace {
+struct LabelPrefix {
+    QString text;
+    int width = 0;
+};
+} // namespace
+
+/**
+ * @brief Label prefixes "1: ", "2: ", ... for the supported ROIs including their widths
+ */
+static const QVector<LabelPrefix>& labelPrefixes() {
+    static const QVector<LabelPrefix> prefixes = [] {
+        QVector<LabelPrefix> output;
+        for (auto index = 1; index <= CnnRoiConfig::getMaxRois(); index++) {
+            const auto text = QString::number(index) + ": ";
+            output.append(LabelPrefix{text, MyResultImage::labelWidth(text)});
+        }
+        return output;
+    }();
+
+    return prefixes;
+}
+
 MyResultImage::MyResultImage(const QByteArray& name)
   : ResultImage(name) {}
 
@@ -22,6 +49,15 @@ void MyResultImage::setImageWithOverlay(const QImage& fullImage,
         return;
     }
 
+    const auto outImage = drawOverlay(fullImage, overlay);
+    if (!outImage.isNull()) {
+        _image = outImage;
+    }
+
+    setModified(image->key());
+}
+
+QImage MyResultImage::drawOverlay(const QImage& fullImage, const QList<overlayData>& overlay) {
     auto imageFormat = fullImage.format();
     if (imageFormat == QImage::Format_Mono or imageFormat == QImage::Format_Grayscale8) {
         imageFormat = QImage::Format_RGB888;
@@ -41,42 +77,41 @@ void MyResultImage::setImageWithOverlay(const QImage& fullImage,
 
         auto fontStartFont = painter.font();
         auto fontStartPixelSize = fontStartFont.pixelSize();
-        quint32 index = 1;
+        const auto& prefixes = labelPrefixes();
+        static const auto probabilityWidth = labelWidth(QStringLiteral(" 0.00"));
+        int index = 0;
         if (!overlay.empty()) {
             for (const auto& val : overlay) {
-                // Reset Font on every ROI
-                fontStartFont.setPixelSize(fontStartPixelSize);
-                painter.setFont(fontStartFont);
-
                 QColor color;
-                auto thisClass = val.result.first;
-                thisClass.prepend(QString::number(index++) + ": ");
-                const auto thisProbability = QString::number(val.result.second, 'f', 2).left(4);
+                const auto& prefix = index < prefixes.size() ? prefixes.at(index)
+                                                             : LabelPrefix{QString::number(index + 1) + ": "};
+                index++;
+                const auto thisProbability = QString::number(val.probability, 'f', 2).left(4);
                 const auto currentRoi = val.roi;
                 color = _idsBlueLight;
                 pen.setColor(color);
                 painter.setPen(pen);
                 painter.drawRect(currentRoi); // Detected Box
 
-                const auto roiText = thisClass + " " + thisProbability;
-                auto textbox = painter.fontMetrics().boundingRect(roiText);
-                qCDebug(lc) << "Textbox original" << textbox << "Text" << roiText;
-                while (currentRoi.width() < textbox.width()) {
-                    auto f = painter.font();
-                    qCDebug(lc) << f.pixelSize();
-                    if (f.pixelSize() < FONT_MINIMAL_PIXEL_SIZE) {
+                const auto roiText = prefix.text + val.classes->name(val.classIndex) + " " + thisProbability;
+
+                // Shrink the font until the label fits into the ROI. The widths are measured once at the initial
+                // font size, so they only need to be scaled here instead of measuring the text for every step.
+                const auto textWidth = prefix.width + val.classes->labelWidth(val.classIndex) + probabilityWidth;
+                auto pixelSize = fontStartPixelSize;
+                while (currentRoi.width() < textWidth * pixelSize / fontStartPixelSize) {
+                    if (pixelSize < FONT_MINIMAL_PIXEL_SIZE) {
                         qCDebug(lc) << "Font too small";
-                        f.setPixelSize(FONT_MINIMAL_PIXEL_SIZE);
-                        painter.setFont(f);
-                        textbox = painter.fontMetrics().boundingRect(roiText);
+                        pixelSize = FONT_MINIMAL_PIXEL_SIZE;
                         break;
                     }
 
-                    f.setPixelSize(static_cast<int>(static_cast<float>(f.pixelSize()) * BOX_SCALING_FACTOR));
-                    qCDebug(lc) << f.pixelSize();
-                    painter.setFont(f);
-                    textbox = painter.fontMetrics().boundingRect(roiText);
+                    pixelSize = static_cast<int>(static_cast<float>(pixelSize) * BOX_SCALING_FACTOR);
                 }
+                fontStartFont.setPixelSize(pixelSize);
+                painter.setFont(fontStartFont);
+                auto textbox = painter.fontMetrics().boundingRect(roiText);
+                qCDebug(lc) << "Textbox" << textbox << "Text" << roiText;
                 if (currentRoi.y() >= textbox.height()) {
                     textbox = QRect(currentRoi.x(),
                                     currentRoi.y() - textbox.height(),
@@ -102,12 +137,12 @@ void MyResultImage::setImageWithOverlay(const QImage& fullImage,
             }
         }
         painter.end();
-        _image = outImage;
     } catch (...) {
         qCDebug(lc) << "Drawing failed.";
+        return QImage{};
     }
 
-    setModified(image->key());
+    return outImage;
 }
 
 QImage MyResultImage::getImage() const {
@@ -123,3 +158,10 @@ void MyResultImage::setImage(const QImage& image, const std::shared_ptr<IDS::NXT
 
     setModified(nxtImage->key());
 }
+
+int MyResultImage::labelWidth(const QString& text) {
+    QFont DejaVuSans(QStringLiteral("DejaVuSans"));
+    DejaVuSans.setPixelSize(FONT_PIXEL_SIZE);
+
+    return QFontMetrics(DejaVuSans).boundingRect(text).width();
+}
@@ -4,11 +4,15 @@
 #include "image.h"
 #include "resultimage.h"
 
+#include "cnnclasstable.h"
+
 class MyResultImage : public IDS::NXT::ResultImage {
     Q_OBJECT
 public:
     struct overlayData {
-        QPair<QString, float> result;
+        std::shared_ptr<const CnnClassTable> classes;
+        int classIndex = 0;
+        float probability = 0.f;
         QRect roi;
         int color = 0;
     };
@@ -21,14 +25,29 @@ public:
     void setImage(const QImage& image, const std::shared_ptr<IDS::NXT::Hardware::Image>& nxtImage);
     QImage getImage() const override;
 
+    /**
+     * @brief Draws the overlay of the ROI results
+     * @param fullImage Image the overlay is drawn on
+     * @param overlay Results of the ROIs
+     * @return Result image, a null image if drawing failed
+     */
+    static QImage drawOverlay(const QImage& fullImage, const QList<overlayData>& overlay);
+
+    /**
+     * @brief Measures the width of a label text at the initial overlay font size
+     * @param text Label text
+     * @return Width in px
+     */
+    static int labelWidth(const QString& text);
+
 private:
     QImage _image;
 
-    const QColor _idsBlueLight = QColor(119, 203, 210);
-    const QColor _idsBlue = QColor(0, 138, 150);
-    const QColor _idsGreen = QColor(81, 192, 119);
-    const QColor _idsGray = QColor(202, 202, 201);
-    const QColor _idsYellow = QColor(255, 204, 96);
-    const QColor _idsOrange = QColor(255, 173, 100);
-    const QColor _errorRed = QColor("red");
+    static inline const QColor _idsBlueLight = QColor(119, 203, 210);
+    static inline const QColor _idsBlue = QColor(0, 138, 150);
+    static inline const QColor _idsGreen = QColor(81, 192, 119);
+    static inline const QColor _idsGray = QColor(202, 202, 201);
+    static inline const QColor _idsYellow = QColor(255, 204, 96);
+    static inline const QColor _idsOrange = QColor(255, 173, 100);
+    static inline const QColor _errorRed = QColor("red");
 };
@@ -1,48 +1,400 @@
 // Include the own header
 #include "myvision.h"
 #include "cnnmanager_v2.h"
+#include "imagepreprocessor.h"
+#include "resultmerger.h"
+#include "softmax.h"
+#include "trace.h"
 
+#include <QElapsedTimer>
 #include <QImage>
 #include <QLoggingCategory>
+#include <QThread>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 static QLoggingCategory lc{"multicnnclassifier.vision"};
 
+/**
+ * @brief Sets the affinity of the calling thread
+ * @param core Index of the core, -1 allows all cores
+ *
+ * The worker threads of the framework are reused, so the affinity is only changed if it differs from the one set
+ * last time in this thread.
+ */
+static void pinToCore(int core) {
+#ifdef Q_OS_LINUX
+    static thread_local int pinnedCore = -1;
+    if (core == pinnedCore) {
+        return;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (core >= 0) {
+        CPU_SET(core, &cpuSet);
+    } else {
+        for (auto cnt = 0; cnt < QThread::idealThreadCount(); cnt++) {
+            CPU_SET(cnt, &cpuSet);
+        }
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0) {
+        pinnedCore = core;
+    } else {
+        qCWarning(lc) << "Can not pin the vision to core" << core;
+    }
+#else
+    Q_UNUSED(core)
+#endif
+}
+
 void MyVision::process() {
+    // Get the image data
+    auto img = image();
+    _processedImage = img.get();
+
     try {
-        // Get the image data
-        auto img = image();
-
-        if (!_cnnData.empty()) {
-            for (auto& cnn : _cnnData) {
-                // process image with deep ocean core.
-                // Scale the image to the input size of the cnn. If you don't scale it the NXT Framework will do scaling
-                // which can lower performance
-                _result[cnn] = cnn.cnnData.processImage(img->getQImage().copy(cnn.roi).scaled(cnn.cnnData.inputSize()),
-                                                        QStringLiteral("Classification"));
+        QElapsedTimer elapsed;
+        elapsed.start();
+        pinToCore(_cpuCore);
+        _imageHoldTimeUs = 0;
+        _imageCopy = QImage();
+        resetResults();
+
+        if (_cnnData && !_cnnData->empty()) {
+            // Cut out all inputs first, the sensor image is not needed anymore afterwards. The cascade stages are
+            // cut out as well, even if an earlier stage decides.
+            {
+                const auto fullImage = img->getQImage();
+                _sourceFormat = fullImage.format();
+                // the ROIs are in sensor coordinates, an image of the sensor AOI starts at the AOI offset
+                _imageOffset = _sensorAoi.offset(fullImage.size());
+                for (auto cnt = 0; cnt < _cnnData->size(); cnt++) {
+                    Trace::Span span("crop", cnt);
+                    const auto roi = _cnnData->at(cnt).roi.translated(-_imageOffset);
+                    for (auto& input : _inputImages[cnt]) {
+                        ImagePreprocessor::cropAndScale(fullImage, roi, input);
+                    }
+                }
+                if (_copyImage) {
+                    _imageCopy = fullImage.copy();
+                }
+            }
+
+            // Release the image buffer, so the framework can capture the next image while the CNNs run. The
+            // result merger acknowledges it once the engines of all shards cut out their ROIs.
+            _imageHoldTimeUs = elapsed.nsecsElapsed() / 1000;
+            releaseImage(img, QString());
+
+            // Record the cut out ROIs, they are owned by the vision object and not part of the sensor image. The
+            // writer is only held for this image, so the file is finalized as soon as the recording is stopped.
+            const auto captureWriter = std::move(_captureWriter);
+            if (captureWriter) {
+                captureWriter->recordFrame(_inputImages);
             }
 
-            img->visionOK("", "");
+            evaluate(elapsed);
         } else // Deep ocean core is not initialized. This can happen if no cnn is ativated.
         {
-            image()->visionFailed("Deep ocean core is not initialized", "Deep ocean core is not initialized");
+            _error = QStringLiteral("Deep ocean core is not initialized");
+        }
+    } catch (std::exception& e) {
+        qCCritical(lc) << "Error: " << e.what();
+
+        // The ROIs which were not finished are published as error by the result handling
+        _error = QString::fromLocal8Bit(e.what());
+    }
+
+    // an image whose ROIs could not be cut out is acknowledged as failed
+    if (img) {
+        releaseImage(img, _error);
+    }
+}
+
+void MyVision::releaseImage(std::shared_ptr<IDS::NXT::Hardware::Image>& image, const QString& failure) {
+    if (_resultMerger) {
+        _resultMerger->releaseImage(image, failure);
+    } else if (failure.isEmpty()) {
+        image->visionOK("", "");
+    } else {
+        image->visionFailed(failure, failure);
+    }
+    image = nullptr;
+    setImage(nullptr);
+}
+
+bool MyVision::replay(const QVector<QVector<QImage>>& inputs) {
+    QElapsedTimer elapsed;
+    elapsed.start();
+    resetResults();
+
+    // The recorded inputs have to fit the active configuration
+    if (!_cnnData || inputs.size() != _inputImages.size()) {
+        return false;
+    }
+    for (auto cnt = 0; cnt < inputs.size(); cnt++) {
+        if (inputs.at(cnt).size() != _inputImages.at(cnt).size()) {
+            return false;
+        }
+        for (auto stageCnt = 0; stageCnt < inputs.at(cnt).size(); stageCnt++) {
+            if (inputs.at(cnt).at(stageCnt).size() != _inputImages.at(cnt).at(stageCnt).size()) {
+                return false;
+            }
         }
+    }
+    _inputImages = inputs;
+
+    try {
+        evaluate(elapsed);
     } catch (std::exception& e) {
         qCCritical(lc) << "Error: " << e.what();
+        _error = QString::fromLocal8Bit(e.what());
+    }
+
+    return true;
+}
+
+void MyVision::resetResults() {
+    // Reuse the result slots of the previous frame
+    for (auto& result : _results) {
+        result.outputs.clear();
+        result.cascadeStage = -1;
+        result.processingTimeUs = 0;
+        result.skipped = false;
+        result.subsampled = false;
+        result.done = false;
+    }
+    _finishedResults = 0;
+    _processingTimeUs = 0;
+    _error.clear();
+}
+
+void MyVision::evaluate(const QElapsedTimer& elapsed) {
+    for (auto cnt = 0; cnt < _cnnData->size(); cnt++) {
+        const auto& cnn = _cnnData->at(cnt);
+        auto& result = _results[static_cast<size_t>(cnt)];
+        // The list is sorted by priority, so only the lower priority ROIs are left when time runs out
+        if (_abortRequested || (_frameBudgetMs > 0 && elapsed.elapsed() >= _frameBudgetMs)) {
+            result.skipped = true;
+            finish(result);
+            continue;
+        }
+        if (!cnn.critical && !_evaluateNonCritical) {
+            result.subsampled = true;
+            finish(result);
+            continue;
+        }
+        Trace::Span span("infer", cnt);
+        auto& inputs = _inputImages[cnt];
+        const auto roiStart = elapsed.nsecsElapsed();
+
+        // Evaluate the cascade first, the CNN of the ROI is only needed if no stage is confident enough
+        auto decided = false;
+        for (auto stageCnt = 0; stageCnt < cnn.cascade.size() && !decided; stageCnt++) {
+            const auto& stage = cnn.cascade.at(stageCnt);
+            auto stageCnnData = stage.cnnData;
+            auto output = stageCnnData.processImage(inputs[stageCnt], QStringLiteral("Classification"));
+            const auto& descriptor = *stage.descriptor;
+            const auto top = descriptor.kernels().top(*output, descriptor.classCount(), stage.outputFormat);
+            if (top.second >= stage.threshold) {
+                // report the result with the CNN of the deciding stage
+                result.outputs.push_back(std::move(output));
+                result.cascadeStage = stageCnt;
+                result.processingTimeUs = (elapsed.nsecsElapsed() - roiStart) / 1000;
+                finish(result);
+                decided = true;
+            }
+        }
+        if (decided) {
+            continue;
+        }
+
+        // The list is shared with other vision objects, so run the CNN on an own handle
+        auto cnnData = cnn.cnnData;
+        // process image with deep ocean core.
+        // The input is already scaled to the input size of the cnn. If you don't scale it the NXT Framework
+        // will do scaling which can lower performance
+        auto& input = inputs.last();
+
+        if (cnn.ensemble.isEmpty()) {
+            result.outputs.push_back(cnnData.processImage(input, QStringLiteral("Classification")));
+        } else {
+            // The ensemble runs concurrently on the same input, the CNN of the ROI on this thread
+            result.outputs.resize(static_cast<size_t>(cnn.ensemble.size()) + 1);
+            _ensembleTasks.clear();
+            _ensembleTasks.emplace_back([&cnnData, &input, &result]() {
+                result.outputs[0] = cnnData.processImage(input, QStringLiteral("Classification"));
+            });
+            for (auto member = 0; member < cnn.ensemble.size(); member++) {
+                _ensembleTasks.emplace_back([&cnn, &input, &result, member]() {
+                    auto memberData = cnn.ensemble.at(member);
+                    result.outputs[static_cast<size_t>(member) + 1] =
+                        memberData.processImage(input, QStringLiteral("Classification"));
+                });
+            }
+            _ensembleWorkers->run(_ensembleTasks);
+        }
+        result.processingTimeUs = (elapsed.nsecsElapsed() - roiStart) / 1000;
+        finish(result);
+    }
+    _processingTimeUs = elapsed.nsecsElapsed() / 1000;
+}
 
-        image()->visionFailed("CNN evaluation failed", "CNN evaluation failed");
+/**
+ * @brief Checks whether the input buffers fit the CNNs of a ROI/CNN list
+ * @return True if every ROI has a buffer of the input size of each of its CNNs in the given format
+ */
+static bool inputsFit(const QVector<QVector<QImage>>& inputs,
+                      const MyVision::RoiCnnList& roiCnnList,
+                      QImage::Format format) {
+    if (inputs.size() != roiCnnList.size()) {
+        return false;
     }
+    for (auto index = 0; index < roiCnnList.size(); index++) {
+        const auto& cnn = roiCnnList.at(index);
+        const auto& roiInputs = inputs.at(index);
+        if (roiInputs.size() != cnn.cascade.size() + 1 || roiInputs.last().format() != format
+            || roiInputs.last().size() != cnn.descriptor->inputSize()) {
+            return false;
+        }
+        for (auto stage = 0; stage < cnn.cascade.size(); stage++) {
+            if (roiInputs.at(stage).format() != format
+                || roiInputs.at(stage).size() != cnn.cascade.at(stage).descriptor->inputSize()) {
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
 void MyVision::abort() {
+    // Skip the ROIs which are not evaluated yet
+    _abortRequested = true;
+
     // Abort the vision process
     Vision::abort();
 }
 
-void MyVision::setCnnData(const RoiCnnList& roiCnnConfig) {
-    _cnnData = roiCnnConfig;
+void MyVision::setCnnData(RoiCnnListPtr roiCnnConfig, QImage::Format inputFormat) {
+    if (roiCnnConfig == _cnnData) {
+        return;
+    }
+    _cnnData = std::move(roiCnnConfig);
+
+    // Allocate the result slots and the input buffers for the new configuration, one input buffer for every
+    // cascade stage and the CNN of a ROI
+    inputFormat = ImagePreprocessor::targetFormat(inputFormat);
+    _results = std::vector<RoiResult>(_cnnData ? static_cast<size_t>(_cnnData->size()) : 0);
+    _finishedResults = 0;
+
+    // The ensemble members of a ROI run in parallel, the threads are kept for every frame with this configuration
+    auto ensembleSize = 0;
+    if (_cnnData) {
+        for (const auto& cnn : *_cnnData) {
+            ensembleSize = std::max(ensembleSize, static_cast<int>(cnn.ensemble.size()));
+        }
+    }
+    if (!_ensembleWorkers || _ensembleWorkers->threadCount() != ensembleSize) {
+        _ensembleWorkers = ensembleSize > 0 ? std::make_unique<WorkerPool>(ensembleSize) : nullptr;
+    }
+
+    // moved ROIs keep their CNNs, so the buffers of the previous list are still used
+    if (_cnnData && inputsFit(_inputImages, *_cnnData, inputFormat)) {
+        return;
+    }
+    _inputImages.clear();
+    if (_cnnData) {
+        _inputImages.reserve(_cnnData->size());
+        for (const auto& cnn : *_cnnData) {
+            QVector<QImage> inputs;
+            for (const auto& stage : cnn.cascade) {
+                inputs.append(QImage(stage.descriptor->inputSize(), inputFormat));
+            }
+            inputs.append(QImage(cnn.descriptor->inputSize(), inputFormat));
+            _inputImages.append(inputs);
+        }
+    }
+}
+
+void MyVision::setFrameBudget(int budgetMs) {
+    _frameBudgetMs = budgetMs;
+    _abortRequested = false;
+}
+
+void MyVision::setSensorAoi(const SensorAoi& sensorAoi) {
+    _sensorAoi = sensorAoi;
+}
+
+QPoint MyVision::imageOffset() const {
+    return _imageOffset;
+}
+
+void MyVision::setEvaluateNonCritical(bool evaluate) {
+    _evaluateNonCritical = evaluate;
+}
+
+qint64 MyVision::processingTimeUs() const {
+    return _processingTimeUs;
+}
+
+void MyVision::setCopyImage(bool copyImage) {
+    _copyImage = copyImage;
+}
+
+QImage MyVision::imageCopy() const {
+    return _imageCopy;
+}
+
+qint64 MyVision::imageHoldTimeUs() const {
+    return _imageHoldTimeUs;
+}
+
+void MyVision::setCaptureWriter(std::shared_ptr<CaptureWriter> captureWriter) {
+    _captureWriter = std::move(captureWriter);
+}
+
+void MyVision::setResultMerger(ResultMerger* resultMerger) {
+    _resultMerger = resultMerger;
+}
+
+void MyVision::setCpuCore(int core) {
+    _cpuCore = core;
+}
+
+QImage::Format MyVision::sourceFormat() const {
+    return _sourceFormat;
+}
+
+const IDS::NXT::Hardware::Image* MyVision::processedImage() const {
+    return _processedImage;
+}
+
+QString MyVision::error() const {
+    return _error;
+}
+
+MyVision::RoiCnnListPtr MyVision::roiCnnList() const {
+    return _cnnData;
+}
+
+int MyVision::finishedResults() const {
+    return _finishedResults;
+}
+
+const QVector<QImage>& MyVision::inputs(int index) const {
+    return _inputImages.at(index);
+}
+
+const MyVision::RoiResult& MyVision::result(int index) const {
+    return _results.at(static_cast<size_t>(index));
 }
 
-MyVision::RoiCnnResultMap MyVision::result() {
-    // we need to move the result because it is stored in an unique pointer.
-    return std::move(_result);
+void MyVision::finish(RoiResult& result) {
+    result.done = true;
+    _finishedResults++;
 }
@@ -5,7 +5,21 @@
 #include <configurableroi.h>
 #include <vision.h>
 
+#include <QElapsedTimer>
 #include <QImage>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "capture.h"
+#include "cnndescriptor.h"
+#include "cnnroiconfig.h"
+#include "sensoraoi.h"
+#include "workerpool.h"
+
+class ResultMerger;
 
 /**
  * @brief The app-specific vision object
@@ -14,6 +28,19 @@ class MyVision : public IDS::NXT::Vision {
     Q_OBJECT
 
 public:
+    /**
+     * @brief Helper class for one stage of an early-exit cascade
+     */
+    class CnnStage {
+    public:
+        IDS::NXT::CNNv2::CnnData cnnData;
+        std::shared_ptr<const CnnDescriptor> descriptor;
+        QByteArray jsonPrefix;
+        OutputFormat outputFormat;
+        double threshold = 1.;
+        QVector<bool> okClasses; // by class index, true for the OK classes of the ROI
+    };
+
     /**
      * @brief Helper class for the assignment of a CNN to a ROI
      */
@@ -21,15 +48,44 @@ public:
     public:
         QRect roi;
         QString roiName;
+        int priority = 0;
+        int shard = 0; // index of the engine which evaluates the ROI
+        bool critical = false; // keeps its full rate when the vision app is overloaded
         IDS::NXT::CNNv2::CnnData cnnData;
-
-        bool operator<(const RoiCnn& rhs) const {
-            return roiName < rhs.roiName;
-        }
+        std::shared_ptr<const CnnDescriptor> descriptor;
+        QByteArray jsonPrefix; // <tt>{"CNN":"<cnn>","ROI":"<roi>","Result":</tt>
+        QList<CnnStage> cascade; // evaluated in order before cnnData, the first confident stage decides
+        QList<IDS::NXT::CNNv2::CnnData> ensemble; // evaluated together with cnnData on the same input
+        QList<std::shared_ptr<const CnnDescriptor>> ensembleDescriptors;
+        CnnRoiConfig::CnnRoiMap::Fusion fusion = CnnRoiConfig::CnnRoiMap::Fusion::Average;
+        CnnRoiConfig::CnnRoiMap::Smoothing smoothing;
+        QVector<OutputFormat> outputFormats; // output formats of cnnData followed by the ensemble
+        int verdictBit = -1; // bit in the OK mask, -1 if the ROI has no OK rule
+        QVector<bool> okClasses; // by class index, true for the OK classes of the ROI
+        double okThreshold = 0.; // minimum probability of an OK class
     };
 
     using RoiCnnList = QList<RoiCnn>;
-    using RoiCnnResultMap = std::map<RoiCnn, std::unique_ptr<IDS::NXT::CNNv2::MultiBuffer>>;
+    using RoiCnnListPtr = std::shared_ptr<const RoiCnnList>;
+    using CnnOutputs = std::vector<std::unique_ptr<IDS::NXT::CNNv2::MultiBuffer>>; // CNN first, then the ensemble
+
+    /**
+     * @brief Result slot of one ROI
+     *
+     * There is one slot per ROI, addressed by the index of the ROI in the ROI/CNN list. The vision object evaluates
+     * the ROIs one after the other and the engine reads the slots only after the processing finished, so the slots
+     * are plain fields. A slot which is not marked as done was not evaluated, e.g. because an inference failed. The
+     * slots are reused frame by frame and only reallocated when the configuration changes.
+     */
+    class RoiResult {
+    public:
+        CnnOutputs outputs;
+        int cascadeStage = -1; // index of the deciding cascade stage, -1 if the CNN of the ROI decided
+        qint64 processingTimeUs = 0; // time of all CNNs of the ROI
+        bool skipped = false; // the frame budget ran out or the processing was aborted
+        bool subsampled = false; // not evaluated in this frame to reduce the load
+        bool done = false;
+    };
 
     /**
      * @brief Constructor
@@ -46,20 +102,188 @@ public:
     void abort() override;
 
     /**
-     * @brief Getter for the vision result
-     * @return Result
+     * @brief Getter for the ROI/CNN list of the last processed image
+     * @return ROI/CNN list, the result slots have the same order
+     */
+    RoiCnnListPtr roiCnnList() const;
+
+    /**
+     * @brief Getter for the number of finished result slots
+     * @return Number of slots marked as done, equals the number of ROIs if all of them were handled
+     */
+    int finishedResults() const;
+
+    /**
+     * @brief Getter for the result slot of a ROI
+     * @param index Index of the ROI in the ROI/CNN list
+     * @return Result slot, its content is only valid if it is marked as done
      */
-    RoiCnnResultMap result();
+    const RoiResult& result(int index) const;
+
+    /**
+     * @brief Getter for the cut out ROI of the last processed image
+     * @param index Index of the ROI in the ROI/CNN list
+     * @return CNN inputs of the cascade stages followed by the one of the CNN
+     */
+    const QVector<QImage>& inputs(int index) const;
 
     /**
      * @brief Setter for ROI/CNN configuration
      * @param roiCnnConfig Configuration object
+     * @param inputFormat Expected image format of the CNN input buffers
+     *
+     * The CNN input buffers are allocated here whenever the configuration changes, so the processing of a frame
+     * does not have to allocate them.
+     */
+    void setCnnData(RoiCnnListPtr roiCnnConfig, QImage::Format inputFormat = QImage::Format_RGB888);
+
+    /**
+     * @brief Setter for the processing time budget of a frame
+     * @param budgetMs Budget in ms, 0 disables the budget
+     *
+     * This is set up for every frame and also resets an abort request of the previous frame.
+     */
+    void setFrameBudget(int budgetMs);
+
+    /**
+     * @brief Setter for the sensor AOI
+     * @param sensorAoi AOI the camera reads out, the ROIs are translated if an image has its size
+     */
+    void setSensorAoi(const SensorAoi& sensorAoi);
+
+    /**
+     * @brief Getter for the position of the last processed image on the sensor
+     * @return Offset by which the ROIs were translated, (0, 0) for a full sensor image
+     */
+    QPoint imageOffset() const;
+
+    /**
+     * @brief Setter for the evaluation of the ROIs which are not critical
+     * @param evaluate False to skip them in the next image, e.g. to reduce the load
      */
-    void setCnnData(const RoiCnnList& roiCnnConfig);
+    void setEvaluateNonCritical(bool evaluate);
+
+    /**
+     * @brief Getter for the processing time of the last image
+     * @return Time from the start of the processing until the last ROI was evaluated in us
+     */
+    qint64 processingTimeUs() const;
+
+    /**
+     * @brief Setter for the copy of the sensor image
+     * @param copyImage Flag to keep a copy of the sensor image, e.g. for the result image
+     *
+     * The sensor image is released as soon as the CNN inputs are cut out. Everything needed later has to be
+     * taken from the copy.
+     */
+    void setCopyImage(bool copyImage);
+
+    /**
+     * @brief Getter for the copy of the sensor image
+     * @return Copy of the last processed image, a null image if no copy was requested
+     */
+    QImage imageCopy() const;
+
+    /**
+     * @brief Getter for the time the image buffer was held
+     * @return Time from the start of the processing until the vision object released the image in us
+     */
+    qint64 imageHoldTimeUs() const;
+
+    /**
+     * @brief Setter for the recording of the CNN inputs
+     * @param captureWriter Capture file the cut out ROIs of the next image are written to, nullptr if not recording
+     */
+    void setCaptureWriter(std::shared_ptr<CaptureWriter> captureWriter);
+
+    /**
+     * @brief Setter for the merger which acknowledges the images
+     * @param resultMerger Merger the image is released to once the ROIs are cut out, nullptr to acknowledge the
+     * image directly
+     */
+    void setResultMerger(ResultMerger* resultMerger);
+
+    /**
+     * @brief Evaluates recorded CNN inputs instead of a sensor image
+     * @param inputs Cut out ROIs of a recorded image, in the layout of the input buffers
+     * @return False if the inputs do not fit the active configuration
+     *
+     * The results are available in the result slots afterwards, like after the processing of an image.
+     */
+    bool replay(const QVector<QVector<QImage>>& inputs);
+
+    /**
+     * @brief Setter for the CPU core the processing runs on
+     * @param core Index of the core, -1 allows all cores
+     */
+    void setCpuCore(int core);
+
+    /**
+     * @brief Getter for the format of the last processed image
+     * @return Image format
+     */
+    QImage::Format sourceFormat() const;
+
+    /**
+     * @brief Getter for the identity of the last processed image
+     * @return Image object, the vision object does not hold it anymore after the ROIs were cut out
+     *
+     * This is only used to look up the image held by the result merger, it must not be dereferenced.
+     */
+    const IDS::NXT::Hardware::Image* processedImage() const;
+
+    /**
+     * @brief Getter for the error of the last processed image
+     * @return Message of the exception which stopped the evaluation, empty if all ROIs were handled
+     */
+    QString error() const;
 
 private:
-    RoiCnnResultMap _result;
-    RoiCnnList _cnnData;
+    /**
+     * @brief Prepares the result slots for a new image
+     */
+    void resetResults();
+
+    /**
+     * @brief Runs the CNNs on the cut out ROIs
+     * @param elapsed Timer started with the processing of the image, used for the frame budget
+     */
+    void evaluate(const QElapsedTimer& elapsed);
+
+    /**
+     * @brief Marks a result slot as done
+     * @param result Result slot
+     */
+    void finish(RoiResult& result);
+
+    /**
+     * @brief Hands the image back once it is not needed anymore and drops the references to it
+     * @param image Image, it is reset
+     * @param failure Message if the ROIs could not be cut out, empty if they were
+     */
+    void releaseImage(std::shared_ptr<IDS::NXT::Hardware::Image>& image, const QString& failure);
+
+    std::vector<RoiResult> _results;
+    int _finishedResults = 0;
+    RoiCnnListPtr _cnnData;
+    int _frameBudgetMs = 0;
+    int _cpuCore = -1;
+    bool _evaluateNonCritical = true;
+    SensorAoi _sensorAoi;
+    QPoint _imageOffset;
+    qint64 _processingTimeUs = 0;
+    bool _copyImage = false;
+    QImage _imageCopy;
+    qint64 _imageHoldTimeUs = 0;
+    std::shared_ptr<CaptureWriter> _captureWriter;
+    ResultMerger* _resultMerger = nullptr;
+    const IDS::NXT::Hardware::Image* _processedImage = nullptr;
+    QString _error;
+    std::atomic_bool _abortRequested{false};
+    QVector<QVector<QImage>> _inputImages;
+    std::unique_ptr<WorkerPool> _ensembleWorkers; // nullptr if no ROI has an ensemble
+    std::vector<WorkerPool::Task> _ensembleTasks;
+    QImage::Format _sourceFormat = QImage::Format_Invalid;
 };
 
 #endif // MYVISION_H
@@ -0,0 +1,78 @@
+#include "outputformat.h"
+
+#include <QString>
+
+#include <stdexcept>
+
+static constexpr auto OUTPUT_TAG_TYPE = "Type";
+static constexpr auto OUTPUT_TAG_SCALE = "Scale";
+static constexpr auto OUTPUT_TAG_ZEROPOINT = "ZeroPoint";
+static constexpr auto OUTPUT_TYPE_NATIVE = "Native";
+static constexpr auto OUTPUT_TYPE_FLOAT16 = "Float16";
+static constexpr auto OUTPUT_TYPE_INT8 = "Int8";
+static constexpr auto OUTPUT_TYPE_UINT8 = "UInt8";
+
+OutputFormat::OutputFormat(const QVariantMap& map) {
+    const auto type = map.value(OUTPUT_TAG_TYPE, OUTPUT_TYPE_NATIVE).toString();
+    if (type == OUTPUT_TYPE_NATIVE) {
+        _type = Type::Native;
+    } else if (type == OUTPUT_TYPE_FLOAT16) {
+        _type = Type::Float16;
+    } else if (type == OUTPUT_TYPE_INT8) {
+        _type = Type::Int8;
+    } else if (type == OUTPUT_TYPE_UINT8) {
+        _type = Type::UInt8;
+    } else {
+        throw std::runtime_error("Output type \'" + type.toStdString() + "\' not supported");
+    }
+
+    // scale and zero point are only used for the quantized types
+    if (map.contains(OUTPUT_TAG_SCALE)) {
+        bool ok = true;
+        _scale = map.value(OUTPUT_TAG_SCALE).toDouble(&ok);
+        if (!ok || _scale <= 0.) {
+            throw std::runtime_error("Output scale must be positive");
+        }
+    }
+    if (map.contains(OUTPUT_TAG_ZEROPOINT)) {
+        bool ok = true;
+        _zeroPoint = map.value(OUTPUT_TAG_ZEROPOINT).toInt(&ok);
+        if (!ok) {
+            throw std::runtime_error("Output zero point not valid");
+        }
+    }
+}
+
+QVariantMap OutputFormat::toMap() const {
+    QVariantMap map;
+    switch (_type) {
+    case Type::Float16:
+        map[OUTPUT_TAG_TYPE] = OUTPUT_TYPE_FLOAT16;
+        break;
+    case Type::Int8:
+        map[OUTPUT_TAG_TYPE] = OUTPUT_TYPE_INT8;
+        break;
+    case Type::UInt8:
+        map[OUTPUT_TAG_TYPE] = OUTPUT_TYPE_UINT8;
+        break;
+    default:
+        map[OUTPUT_TAG_TYPE] = OUTPUT_TYPE_NATIVE;
+        break;
+    }
+    map[OUTPUT_TAG_SCALE] = _scale;
+    map[OUTPUT_TAG_ZEROPOINT] = _zeroPoint;
+
+    return map;
+}
+
+OutputFormat::Type OutputFormat::type() const {
+    return _type;
+}
+
+double OutputFormat::scale() const {
+    return _scale;
+}
+
+int OutputFormat::zeroPoint() const {
+    return _zeroPoint;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QVariantMap>
+
+/**
+ * @brief Element type and quantization of the output buffer of a CNN
+ *
+ * Quantized CNNs emit int8/uint8 or fp16 logits. The logit of a quantized value q is scale * (q - zeroPoint).
+ */
+class OutputFormat {
+public:
+    enum class Type {
+        Native,  ///< Buffer elements are used as they are delivered by the framework
+        Float16, ///< IEEE 754 half precision
+        Int8,    ///< Signed 8 bit, quantized
+        UInt8    ///< Unsigned 8 bit, quantized
+    };
+
+    OutputFormat() = default;
+
+    /**
+     * @brief C'tor
+     * @param map Output format map with Type and, for quantized types, Scale and ZeroPoint
+     */
+    explicit OutputFormat(const QVariantMap& map);
+
+    QVariantMap toMap() const;
+    Type type() const;
+    double scale() const;
+    int zeroPoint() const;
+
+private:
+    Type _type = Type::Native;
+    double _scale = 1.;
+    int _zeroPoint = 0;
+};
@@ -0,0 +1,94 @@
+#include "overloadcontroller.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+
+#include <algorithm>
+#include <cmath>
+
+static QLoggingCategory lc{"multicnnclassifier.overload"};
+
+static constexpr double LATENCY_SMOOTHING = 0.2;
+static constexpr int OVERLOAD_FRAMES = 10; // consecutive overloaded frames before the next degradation
+static constexpr int CALM_FRAMES = 50; // consecutive calm frames before the recovery by one mode
+static constexpr double CALM_LATENCY_SHARE = 0.7; // share of the latency limit below which a frame is calm
+
+/**
+ * @brief Name of a mode in the published result
+ */
+static const char* modeName(OverloadController::Mode mode) {
+    switch (mode) {
+    case OverloadController::Mode::NoResultImage:
+        return "NoResultImage";
+    case OverloadController::Mode::Subsampled:
+        return "Subsampled";
+    default:
+        return "Normal";
+    }
+}
+
+void OverloadController::configure(int latencyMs, int subsample, int maxVisionsInFlight) {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    _latencyLimitUs = static_cast<qint64>(latencyMs) * 1000;
+    _subsample = std::max(subsample, 1);
+    _maxVisionsInFlight = std::max(maxVisionsInFlight, 1);
+    _averageLatencyUs = 0.;
+    _overloadedFrames = 0;
+    _calmFrames = 0;
+    if (_mode != Mode::Normal) {
+        setMode(Mode::Normal);
+    }
+}
+
+void OverloadController::addFrame(qint64 latencyUs, int visionsInFlight) {
+    std::lock_guard<std::mutex> locker(_lock);
+    if (_latencyLimitUs <= 0) {
+        return;
+    }
+
+    _averageLatencyUs += LATENCY_SMOOTHING * (static_cast<double>(latencyUs) - _averageLatencyUs);
+    _visionsInFlight = visionsInFlight;
+    const auto overloaded = _averageLatencyUs > _latencyLimitUs || visionsInFlight > _maxVisionsInFlight;
+    const auto calm = _averageLatencyUs < CALM_LATENCY_SHARE * _latencyLimitUs
+                      && visionsInFlight <= _maxVisionsInFlight;
+
+    _overloadedFrames = overloaded ? _overloadedFrames + 1 : 0;
+    _calmFrames = calm ? _calmFrames + 1 : 0;
+
+    const auto mode = _mode.load();
+    if (_overloadedFrames >= OVERLOAD_FRAMES && mode != Mode::Subsampled) {
+        setMode(static_cast<Mode>(static_cast<int>(mode) + 1));
+    } else if (_calmFrames >= CALM_FRAMES && mode != Mode::Normal) {
+        setMode(static_cast<Mode>(static_cast<int>(mode) - 1));
+    }
+}
+
+OverloadController::Mode OverloadController::mode() const {
+    return _mode;
+}
+
+int OverloadController::subsample() const {
+    return _mode == Mode::Subsampled ? _subsample.load() : 1;
+}
+
+QByteArray OverloadController::takeModeChange() {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    QByteArray modeChange;
+    std::swap(modeChange, _modeChange);
+    return modeChange;
+}
+
+void OverloadController::setMode(Mode mode) {
+    _mode = mode;
+    _overloadedFrames = 0;
+    _calmFrames = 0;
+    qCDebug(lc) << "Overload mode changed to" << modeName(mode);
+
+    const QJsonObject modeChange{{"Mode", modeName(mode)},
+                                 {"LatencyMs", std::round(_averageLatencyUs / 10.) / 100.},
+                                 {"VisionsInFlight", _visionsInFlight}};
+    _modeChange = QJsonDocument(modeChange).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QByteArray>
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * @brief Graceful degradation under sustained overload
+ *
+ * The engines report the processing time of every frame and the number of vision objects in flight. If frames
+ * keep exceeding the latency limit or images queue up, the controller steps down one mode; once the load stays
+ * low for a while, it steps up again. Mode changes are published with the next image.
+ */
+class OverloadController {
+public:
+    /**
+     * @brief Degradation modes, ordered by increasing degradation
+     */
+    enum class Mode {
+        Normal,        ///< Everything is evaluated
+        NoResultImage, ///< The result image is not created
+        Subsampled     ///< Additionally, ROIs which are not critical are only evaluated in every n-th frame
+    };
+
+    /**
+     * @brief Sets up the controller for a new configuration and returns to normal mode
+     * @param latencyMs Latency limit of a frame in ms, 0 disables the controller
+     * @param subsample Every n-th frame evaluates the ROIs which are not critical in subsampled mode
+     * @param maxVisionsInFlight Number of vision objects in flight above which images are queuing up
+     */
+    void configure(int latencyMs, int subsample, int maxVisionsInFlight);
+
+    /**
+     * @brief Adds the figures of a processed frame
+     * @param latencyUs Processing time of the frame in us
+     * @param visionsInFlight Number of vision objects processing an image
+     */
+    void addFrame(qint64 latencyUs, int visionsInFlight);
+
+    /**
+     * @brief Getter for the current mode
+     * @return Mode
+     */
+    Mode mode() const;
+
+    /**
+     * @brief Getter for the rate of the ROIs which are not critical
+     * @return They are evaluated in every n-th frame, 1 if they are evaluated in every frame
+     */
+    int subsample() const;
+
+    /**
+     * @brief Takes the latest mode change for publishing
+     * @return JSON describing the new mode, empty if the mode did not change since the last call
+     */
+    QByteArray takeModeChange();
+
+private:
+    void setMode(Mode mode);
+
+    std::mutex _lock;
+    std::atomic<Mode> _mode{Mode::Normal};
+    std::atomic_int _subsample{1};
+    qint64 _latencyLimitUs = 0;
+    int _maxVisionsInFlight = 1;
+    double _averageLatencyUs = 0.;
+    int _visionsInFlight = 0;
+    int _overloadedFrames = 0;
+    int _calmFrames = 0;
+    QByteArray _modeChange;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Pointer to an immutable snapshot which is replaced as a whole
+ *
+ * Writers publish a complete new object instead of changing the current one, readers take a reference counted
+ * snapshot and keep using it without a lock. The old object is released when the last reader drops its snapshot,
+ * so a reader never sees a half written state and a writer never waits for a reader.
+ */
+template <typename T>
+class RcuPointer {
+public:
+    /**
+     * @brief C'tor
+     * @param value Initial snapshot
+     */
+    explicit RcuPointer(std::shared_ptr<T> value = std::make_shared<T>())
+      : _value{std::move(value)} {}
+
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    /**
+     * @brief Returns the current snapshot, it stays valid while the caller holds it
+     */
+    std::shared_ptr<T> load() const {
+        return std::atomic_load(&_value);
+    }
+
+    /**
+     * @brief Publishes a new snapshot
+     * @param value Snapshot, it must not be changed afterwards
+     */
+    void store(std::shared_ptr<T> value) {
+        std::atomic_store(&_value, std::move(value));
+    }
+
+private:
+    std::shared_ptr<T> _value;
+};
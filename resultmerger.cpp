@@ -0,0 +1,220 @@
+#include "resultmerger.h"
+
+#include <QLoggingCategory>
+
+#include <algorithm>
+
+#include "trace.h"
+
+static QLoggingCategory lc{"multicnnclassifier.resultmerger"};
+
+// an image whose parts are not finished after this time is given up, its remaining parts are lost
+static constexpr qint64 PENDING_IMAGE_TIMEOUT_MS = 10000;
+
+ResultMerger::ResultMerger(IDS::NXT::ResultSourceCollection& resultcollection,
+                           Metrics& metrics,
+                           OverloadController& overloadController)
+  : _resultCollection{resultcollection}
+  , _metrics{metrics}
+  , _overloadController{overloadController}
+  , _createResultImage{"createresultimage", false} {
+    // connect configurable bool (switch) changed-event
+    connect(&_createResultImage, &IDS::NXT::ConfigurableBool::changed, this, &ResultMerger::enableResultImage);
+    _clock.start();
+}
+
+void ResultMerger::expect(const std::shared_ptr<IDS::NXT::Hardware::Image>& image, int parts) {
+    QList<PendingImage> stale;
+    {
+        std::lock_guard<std::mutex> locker(_lock);
+
+        // A part which never arrives, e.g. of a vision object aborted on a retired engine, would pin the image
+        const auto now = _clock.elapsed();
+        for (auto iter = _pendingImages.begin(); iter != _pendingImages.end();) {
+            if (now - iter->expectedMs > PENDING_IMAGE_TIMEOUT_MS) {
+                stale.append(*iter);
+                iter = _pendingImages.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+
+        PendingImage pending;
+        pending.image = image;
+        pending.parts = parts;
+        pending.unreleased = parts;
+        pending.expectedMs = now;
+        _pendingImages.insert(image.get(), pending);
+    }
+
+    // the given up images are finished without the missing parts, late parts are ignored
+    for (const auto& pending : qAsConst(stale)) {
+        qCWarning(lc) << "Image dropped," << pending.parts << "parts not finished";
+        if (pending.unreleased > 0) {
+            const auto message = QStringLiteral("Image dropped");
+            pending.image->visionFailed(message, message);
+        }
+        _resultCollection.finishedAllParts(pending.image);
+        _metrics.addDroppedFrame();
+    }
+}
+
+void ResultMerger::finishPart(const std::shared_ptr<IDS::NXT::Hardware::Image>& image, const Part& part) {
+    PendingImage pending;
+    quint64 deadlineMisses = 0;
+    auto publishVerdict = false;
+    quint32 okMask = 0;
+    auto ok = false;
+    std::shared_ptr<MyResultImage> resultImage;
+    {
+        std::lock_guard<std::mutex> locker(_lock);
+
+        auto iter = _pendingImages.find(image.get());
+        if (iter == _pendingImages.end()) {
+            // it was dropped and finished already
+            qCWarning(lc) << "Result for an image which was not announced";
+            return;
+        }
+        auto& merged = iter->merged;
+        iter->overlays.insert(part.shard, part.overlay);
+        if (merged.image.isNull()) {
+            merged.image = part.image;
+        }
+        merged.skippedRois += part.skippedRois;
+        merged.verdictRois |= part.verdictRois;
+        merged.okMask |= part.okMask;
+        merged.reportDeadlineMisses = merged.reportDeadlineMisses || part.reportDeadlineMisses;
+        // the buffer is free once the slowest engine released it
+        merged.imageHoldTimeUs = std::max(merged.imageHoldTimeUs, part.imageHoldTimeUs);
+        if (--iter->parts > 0) {
+            return;
+        }
+        pending = *iter;
+        _pendingImages.erase(iter);
+
+        // the state shared by the images is updated here, everything else is published without the lock
+        if (pending.merged.skippedRois > 0) {
+            _deadlineMisses++;
+        }
+        deadlineMisses = _deadlineMisses;
+        // the ROIs not evaluated in this image keep their last OK state
+        publishVerdict = _verdictRule.roiMask() != 0;
+        if (publishVerdict) {
+            _okMask = ((_okMask & ~pending.merged.verdictRois) | pending.merged.okMask) & _verdictRule.roiMask();
+            okMask = _okMask;
+            ok = _verdictRule.isOk(_okMask);
+        }
+        resultImage = _resultImage;
+    }
+    const auto& merged = pending.merged;
+
+    // report the frames in which ROIs did not fit into the frame budget
+    if (merged.skippedRois > 0) {
+        qCDebug(lc) << "Deadline missed," << merged.skippedRois << "ROIs not evaluated";
+        emit deadlineMissed();
+    }
+    if (merged.reportDeadlineMisses) {
+        _resultCollection.addResult("deadlinemisses",
+                                    QString::number(deadlineMisses),
+                                    QStringLiteral("Deadline misses"),
+                                    image);
+    }
+
+    _resultCollection.addResult("imageholdtime",
+                                QString::number(merged.imageHoldTimeUs / 1000., 'f', 2),
+                                QStringLiteral("Image hold time"),
+                                image);
+
+    if (publishVerdict) {
+        _resultCollection.addResult("okmask", QString::number(okMask), QStringLiteral("OK mask"), image);
+        _resultCollection.addResult("verdict",
+                                    ok ? QStringLiteral("OK") : QStringLiteral("NOK"),
+                                    QStringLiteral("Verdict"),
+                                    image);
+    }
+
+    const auto metrics = _metrics.takeSnapshot();
+    if (!metrics.isEmpty()) {
+        _resultCollection.addResult("metrics", metrics, QStringLiteral("Metrics"), image);
+    }
+
+    const auto modeChange = _overloadController.takeModeChange();
+    if (!modeChange.isEmpty()) {
+        _resultCollection.addResult("overload", modeChange, QStringLiteral("Overload"), image);
+    }
+
+    // The sensor image is already released, so the overlay is drawn on the copy taken by the vision. The ROIs are
+    // labeled in the order of the shards, so the numbering does not depend on which engine finished first.
+    if (resultImage && !merged.image.isNull()) {
+        Trace::Span span("renderResultImage");
+        QList<MyResultImage::overlayData> overlay;
+        for (const auto& shardOverlay : qAsConst(pending.overlays)) {
+            overlay.append(shardOverlay);
+        }
+        const auto drawnImage = MyResultImage::drawOverlay(merged.image, overlay);
+        if (!drawnImage.isNull()) {
+            std::lock_guard<std::mutex> locker(_resultImageLock);
+            resultImage->setImage(drawnImage, image);
+        }
+    }
+
+    // signal that all parts of the image are finished
+    _resultCollection.finishedAllParts(image);
+}
+
+void ResultMerger::releaseImage(const std::shared_ptr<IDS::NXT::Hardware::Image>& image, const QString& failure) {
+    QStringList failures;
+    {
+        std::lock_guard<std::mutex> locker(_lock);
+
+        auto iter = _pendingImages.find(image.get());
+        if (iter == _pendingImages.end() || iter->unreleased == 0) {
+            qCWarning(lc) << "Release of an image which was not announced";
+            return;
+        }
+        if (!failure.isEmpty()) {
+            iter->failures.append(failure);
+        }
+        if (--iter->unreleased > 0) {
+            return;
+        }
+        failures = iter->failures;
+    }
+
+    // the image is acknowledged once for all engines, as failed if one of them could not cut out its ROIs
+    if (failures.isEmpty()) {
+        image->visionOK("", "");
+    } else {
+        const auto message = failures.join(QStringLiteral("; "));
+        image->visionFailed(message, message);
+    }
+}
+
+std::shared_ptr<IDS::NXT::Hardware::Image> ResultMerger::pendingImage(const IDS::NXT::Hardware::Image* image) {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    const auto iter = _pendingImages.constFind(image);
+    return iter != _pendingImages.constEnd() ? iter->image : nullptr;
+}
+
+bool ResultMerger::resultImageEnabled() const {
+    return _resultImageEnabled;
+}
+
+void ResultMerger::setVerdictRule(const VerdictRule& rule) {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    _verdictRule = rule;
+    _okMask = 0;
+}
+
+void ResultMerger::enableResultImage(bool enable) {
+    std::lock_guard<std::mutex> locker(_lock);
+
+    if (enable) {
+        _resultImage = std::make_shared<MyResultImage>("resultimage");
+    } else {
+        _resultImage = nullptr;
+    }
+    _resultImageEnabled = enable;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include <configurablebool.h>
+#include <image.h>
+#include <resultsourcecollection.h>
+
+#include "metrics.h"
+#include "myresultimage.h"
+#include "overloadcontroller.h"
+#include "verdict.h"
+
+/**
+ * @brief Merges the results of the engines which evaluate the ROIs of an image in parallel
+ *
+ * The vision objects of all engines release the image here as soon as they cut out their ROIs, the last release
+ * acknowledges it to the framework. Every engine finishes its part of the image here as well. Once the last part
+ * is finished, the overlay of all parts is drawn into one result image and the image is finished with a single
+ * finishedAllParts(). Only the merging runs under the lock, the results are published and drawn without it.
+ */
+class ResultMerger : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Result of one engine for an image
+     */
+    struct Part {
+        int shard = 0; // index of the engine
+        QList<MyResultImage::overlayData> overlay; // overlay of the ROIs evaluated by the engine
+        QImage image; // copy of the sensor image for the result image
+        int skippedRois = 0; // number of ROIs which did not fit into the frame budget
+        bool reportDeadlineMisses = false; // flag to publish the deadline misses with this image
+        qint64 imageHoldTimeUs = 0; // time the engine held the image buffer
+        quint32 verdictRois = 0; // bits of the ROIs with an OK rule which were evaluated by the engine
+        quint32 okMask = 0; // bits of the evaluated ROIs which are OK
+    };
+
+    /**
+     * @brief C'tor
+     * @param resultcollection The result collection object
+     * @param metrics The metrics, their snapshots are published with the next finished image
+     * @param overloadController The overload control, its mode changes are published with the next finished image
+     */
+    ResultMerger(IDS::NXT::ResultSourceCollection& resultcollection,
+                 Metrics& metrics,
+                 OverloadController& overloadController);
+
+    /**
+     * @brief Announces a new image
+     * @param image Image
+     * @param parts Number of engines the image is handed to
+     *
+     * This has to be called before the image is handed to the engines.
+     */
+    void expect(const std::shared_ptr<IDS::NXT::Hardware::Image>& image, int parts);
+
+    /**
+     * @brief Finishes the part of an engine
+     * @param image Image
+     * @param part Result of the engine
+     */
+    void finishPart(const std::shared_ptr<IDS::NXT::Hardware::Image>& image, const Part& part);
+
+    /**
+     * @brief Releases the image for a vision object which cut out its ROIs
+     * @param image Image
+     * @param failure Message if the vision object could not cut out its ROIs, empty if it did
+     *
+     * Once the vision objects of all engines released the image, it is acknowledged with visionOK, or with
+     * visionFailed and the collected messages. Failures of the CNNs afterwards are published as results.
+     */
+    void releaseImage(const std::shared_ptr<IDS::NXT::Hardware::Image>& image, const QString& failure);
+
+    /**
+     * @brief Getter for an announced image
+     * @param image Image object, e.g. the one a vision object processed and released already
+     * @return Image to publish the results on, nullptr if it was not announced or is finished already
+     *
+     * The results need the image object, so the merger keeps the reference from the announcement until the last
+     * part is finished. The image is acknowledged to the framework before, once all ROIs are cut out.
+     */
+    std::shared_ptr<IDS::NXT::Hardware::Image> pendingImage(const IDS::NXT::Hardware::Image* image);
+
+    /**
+     * @brief Getter for the result image status
+     * @return True if a result image is created
+     */
+    bool resultImageEnabled() const;
+
+    /**
+     * @brief Setter for the verdict rule
+     * @param rule Rule which combines the OK results of the ROIs, the OK mask of the previous rule is dropped
+     */
+    void setVerdictRule(const VerdictRule& rule);
+
+signals:
+    /**
+     * @brief Emitted for every image in which ROIs did not fit into the frame budget
+     */
+    void deadlineMissed();
+
+private slots:
+    /**
+     * @brief Setter for result image status
+     * @param enable Flag to enable/disable result image
+     */
+    void enableResultImage(bool enable);
+
+private:
+    /**
+     * @brief Parts of an image which are not finished yet
+     */
+    struct PendingImage {
+        std::shared_ptr<IDS::NXT::Hardware::Image> image;
+        int parts = 0;
+        int unreleased = 0; // vision objects which did not cut out their ROIs yet
+        qint64 expectedMs = 0; // time of the announcement
+        Part merged;
+        QMap<int, QList<MyResultImage::overlayData>> overlays; // keyed by the shard
+        QStringList failures; // of the vision objects which could not cut out their ROIs
+    };
+
+    IDS::NXT::ResultSourceCollection& _resultCollection;
+    Metrics& _metrics;
+    OverloadController& _overloadController;
+    IDS::NXT::ConfigurableBool _createResultImage;
+    std::shared_ptr<MyResultImage> _resultImage; // held by the rendering of an image while it is replaced
+    std::mutex _resultImageLock;
+    std::atomic_bool _resultImageEnabled{false};
+    quint64 _deadlineMisses = 0;
+    VerdictRule _verdictRule;
+    quint32 _okMask = 0; // subsampled ROIs keep the bit of their last evaluation
+    // keyed by the image object, the framework reuses it only after it was finished
+    QHash<const IDS::NXT::Hardware::Image*, PendingImage> _pendingImages;
+    QElapsedTimer _clock;
+    std::mutex _lock;
+};
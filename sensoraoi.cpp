@@ -0,0 +1,50 @@
+#include "sensoraoi.h"
+
+#include <algorithm>
+
+static constexpr int AOI_ALIGNMENT_X = 8;
+static constexpr int AOI_ALIGNMENT_Y = 2;
+
+SensorAoi::SensorAoi(const QRect& rect)
+  : _rect{rect} {}
+
+SensorAoi SensorAoi::boundingUnion(const QList<QRect>& rois, const QSize& alignment) {
+    QRect united;
+    for (const auto& roi : rois) {
+        united = united.united(roi);
+    }
+    if (united.isEmpty()) {
+        return SensorAoi();
+    }
+
+    // the offset is rounded down and the far edge up, so the aligned AOI still contains all ROIs
+    const auto alignX = std::max(alignment.width(), 1);
+    const auto alignY = std::max(alignment.height(), 1);
+    const auto left = std::max(united.left(), 0) / alignX * alignX;
+    const auto top = std::max(united.top(), 0) / alignY * alignY;
+    const auto right = (united.x() + united.width() + alignX - 1) / alignX * alignX;
+    const auto bottom = (united.y() + united.height() + alignY - 1) / alignY * alignY;
+
+    return SensorAoi(QRect(left, top, right - left, bottom - top));
+}
+
+QSize SensorAoi::defaultAlignment() {
+    return {AOI_ALIGNMENT_X, AOI_ALIGNMENT_Y};
+}
+
+QRect SensorAoi::rect() const {
+    return _rect;
+}
+
+bool SensorAoi::isReduced() const {
+    return _rect.isValid();
+}
+
+QPoint SensorAoi::offset(const QSize& imageSize) const {
+    // images captured before the AOI took effect still have the full size
+    if (!isReduced() || imageSize != _rect.size()) {
+        return {};
+    }
+
+    return _rect.topLeft();
+}
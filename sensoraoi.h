@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QList>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+
+/**
+ * @brief Area of interest of the sensor which covers all ROIs
+ *
+ * If the camera only reads out this area, readout time, memory bandwidth and frame rate scale with the inspected
+ * area instead of the full sensor. The ROIs stay configured in sensor coordinates, images which have the size of the
+ * AOI are recognized and the ROIs are translated by the AOI offset.
+ */
+class SensorAoi {
+public:
+    /**
+     * @brief C'tor for the full sensor
+     */
+    SensorAoi() = default;
+
+    /**
+     * @brief Computes the bounding union of ROIs
+     * @param rois ROIs in sensor coordinates
+     * @param alignment Granularity of the AOI offset and size which the sensor supports
+     * @return AOI which contains all ROIs, the full sensor if there are no ROIs
+     */
+    static SensorAoi boundingUnion(const QList<QRect>& rois, const QSize& alignment = defaultAlignment());
+
+    /**
+     * @brief Getter for the AOI granularity of common sensors
+     * @return Granularity of offset and size in px
+     */
+    static QSize defaultAlignment();
+
+    /**
+     * @brief Getter for the AOI
+     * @return AOI in sensor coordinates, invalid for the full sensor
+     */
+    QRect rect() const;
+
+    /**
+     * @brief Checks if only a part of the sensor is read out
+     * @return False for the full sensor
+     */
+    bool isReduced() const;
+
+    /**
+     * @brief Getter for the position of an image on the sensor
+     * @param imageSize Size of a delivered image
+     * @return Offset of the AOI if the image has the size of the AOI, (0, 0) for a full sensor image
+     */
+    QPoint offset(const QSize& imageSize) const;
+
+private:
+    explicit SensorAoi(const QRect& rect);
+
+    QRect _rect;
+};
@@ -0,0 +1,250 @@
+#include "softmax.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Converts an IEEE 754 half precision value to float
+ */
+static float halfToFloat(quint16 half) {
+    const quint32 sign = static_cast<quint32>(half & 0x8000u) << 16;
+    quint32 exponent = (half >> 10) & 0x1fu;
+    quint32 mantissa = half & 0x3ffu;
+
+    quint32 bits = sign;
+    if (exponent == 0x1fu) {
+        // infinity or NaN
+        bits |= 0x7f800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits |= ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // subnormal, normalize it
+        exponent = 113;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits |= (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Kernels with ClassCount > 0 are specialized for this class count, 0 takes the class count at runtime
+ */
+template <int ClassCount, typename Element, typename Dequantize>
+static double exponentialsOf(const Element* data,
+                             int classCount,
+                             Dequantize dequantize,
+                             Softmax::ClassValues& values) {
+    const auto count = ClassCount > 0 ? ClassCount : classCount;
+    values.resize(count);
+    auto expSum = 0.;
+
+    for (auto cnt = 0; cnt < count; cnt++) {
+        // Apply exponential function for softmax calculation;
+        const auto currentVal = std::exp(static_cast<double>(dequantize(data[cnt])));
+        // Sum up values for softmax dividor
+        expSum += currentVal;
+        values[cnt] = qMakePair(cnt, currentVal);
+    }
+
+    return expSum;
+}
+
+template <int ClassCount, typename Element, typename Dequantize>
+static QPair<int, double> topOf(const Element* data, int classCount, Dequantize dequantize) {
+    if constexpr (ClassCount == 2) {
+        // the probability of the top class is the logistic function of the difference
+        const auto first = static_cast<double>(dequantize(data[0]));
+        const auto second = static_cast<double>(dequantize(data[1]));
+        return second > first ? qMakePair(1, 1. / (1. + std::exp(first - second)))
+                              : qMakePair(0, 1. / (1. + std::exp(second - first)));
+    }
+
+    const auto count = ClassCount > 0 ? ClassCount : classCount;
+    auto topClass = 0;
+    auto topValue = static_cast<double>(dequantize(data[0]));
+    for (auto cnt = 1; cnt < count; cnt++) {
+        const auto value = static_cast<double>(dequantize(data[cnt]));
+        if (value > topValue) {
+            topClass = cnt;
+            topValue = value;
+        }
+    }
+
+    // Relative to the maximum, the exponentials can not overflow
+    auto expSum = 0.;
+    for (auto cnt = 0; cnt < count; cnt++) {
+        expSum += std::exp(static_cast<double>(dequantize(data[cnt])) - topValue);
+    }
+
+    return qMakePair(topClass, 1. / expSum);
+}
+
+/**
+ * @brief Calls the kernel with the output buffer in its element type and the matching dequantization
+ */
+template <typename Kernel>
+static auto decode(const IDS::NXT::CNNv2::MultiBuffer& output,
+                   int classCount,
+                   const OutputFormat& format,
+                   Kernel kernel) {
+    // Classification CNNs have only one output Buffer
+    const auto& allBuffers = output.allBuffers();
+    const auto& buffer = allBuffers.at(0);
+    Softmax::validateOutputSize(static_cast<qint64>(buffer.size), classCount);
+    const auto scale = format.scale();
+    const auto zeroPoint = format.zeroPoint();
+
+    switch (format.type()) {
+    case OutputFormat::Type::Float16:
+        return kernel(reinterpret_cast<const quint16*>(&buffer.data[0]),
+                      [](quint16 value) { return halfToFloat(value); });
+    case OutputFormat::Type::Int8:
+        return kernel(reinterpret_cast<const qint8*>(&buffer.data[0]),
+                      [scale, zeroPoint](qint8 value) { return scale * (value - zeroPoint); });
+    case OutputFormat::Type::UInt8:
+        return kernel(reinterpret_cast<const quint8*>(&buffer.data[0]),
+                      [scale, zeroPoint](quint8 value) { return scale * (value - zeroPoint); });
+    default:
+        return kernel(&buffer.data[0], [](auto value) { return value; });
+    }
+}
+
+template <int ClassCount>
+static double exponentialsKernel(const IDS::NXT::CNNv2::MultiBuffer& output,
+                                 int classCount,
+                                 Softmax::ClassValues& values,
+                                 const OutputFormat& format) {
+    return decode(output, classCount, format, [classCount, &values](const auto* data, auto dequantize) {
+        return exponentialsOf<ClassCount>(data, classCount, dequantize, values);
+    });
+}
+
+template <int ClassCount>
+static QPair<int, double> topKernel(const IDS::NXT::CNNv2::MultiBuffer& output,
+                                    int classCount,
+                                    const OutputFormat& format) {
+    if (ClassCount == 0 && classCount <= 0) {
+        return qMakePair(0, 0.);
+    }
+
+    return decode(output, classCount, format, [classCount](const auto* data, auto dequantize) {
+        return topOf<ClassCount>(data, classCount, dequantize);
+    });
+}
+
+template <int ClassCount>
+static void sortKernel(Softmax::ClassValues& values) {
+    const auto greater = [](const QPair<int, double>& lhs, const QPair<int, double>& rhs) {
+        return lhs.second > rhs.second;
+    };
+
+    if constexpr (ClassCount == 0) {
+        std::sort(values.begin(), values.end(), greater);
+    } else {
+        // insertion sort with a fixed bound, for 2 classes this is a single compare and swap
+        auto* data = values.data();
+        for (auto cnt = 1; cnt < ClassCount; cnt++) {
+            const auto value = data[cnt];
+            auto pos = cnt;
+            for (; pos > 0 && greater(value, data[pos - 1]); pos--) {
+                data[pos] = data[pos - 1];
+            }
+            data[pos] = value;
+        }
+    }
+}
+
+template <int ClassCount>
+static double logitExponentialsKernel(const float* logits, int classCount, Softmax::ClassValues& values) {
+    return exponentialsOf<ClassCount>(logits, classCount, [](float value) { return value; }, values);
+}
+
+template <int ClassCount>
+static constexpr Softmax::Kernels kernelsFor() {
+    return Softmax::Kernels{&exponentialsKernel<ClassCount>,
+                            &topKernel<ClassCount>,
+                            &sortKernel<ClassCount>,
+                            &logitExponentialsKernel<ClassCount>};
+}
+
+double Softmax::exponentials(const IDS::NXT::CNNv2::MultiBuffer& output,
+                             int classCount,
+                             ClassValues& values,
+                             const OutputFormat& format) {
+    return exponentialsKernel<0>(output, classCount, values, format);
+}
+
+QPair<int, double> Softmax::top(const IDS::NXT::CNNv2::MultiBuffer& output,
+                                int classCount,
+                                const OutputFormat& format) {
+    return topKernel<0>(output, classCount, format);
+}
+
+const Softmax::Kernels& Softmax::kernels(int classCount) {
+    // dispatch table by class count, the entries without specialization take the generic kernels
+    static const std::array<Kernels, 11> table{kernelsFor<0>(),
+                                               kernelsFor<0>(),
+                                               kernelsFor<2>(),
+                                               kernelsFor<3>(),
+                                               kernelsFor<0>(),
+                                               kernelsFor<0>(),
+                                               kernelsFor<0>(),
+                                               kernelsFor<0>(),
+                                               kernelsFor<0>(),
+                                               kernelsFor<0>(),
+                                               kernelsFor<10>()};
+
+    return table.at(classCount >= 0 && classCount < static_cast<int>(table.size()) ? classCount : 0);
+}
+
+void Softmax::validateOutputSize(qint64 elements, int classCount) {
+    if (elements != classCount) {
+        throw std::runtime_error("Output buffer has " + std::to_string(elements) + " elements, expected one for each of "
+                                 + std::to_string(classCount) + " classes");
+    }
+}
+
+void Softmax::average(const std::vector<std::unique_ptr<IDS::NXT::CNNv2::MultiBuffer>>& outputs,
+                      const QVector<OutputFormat>& formats,
+                      int classCount,
+                      ClassValues& values) {
+    values.fill(qMakePair(0, 0.), classCount);
+    for (auto cnt = 0; cnt < classCount; cnt++) {
+        values[cnt].first = cnt;
+    }
+
+    ClassValues memberValues;
+    for (size_t member = 0; member < outputs.size(); member++) {
+        const auto format = formats.value(static_cast<int>(member));
+        const auto expSum = exponentials(*outputs.at(member), classCount, memberValues, format);
+        for (auto cnt = 0; cnt < classCount; cnt++) {
+            values[cnt].second += memberValues.at(cnt).second / expSum / static_cast<double>(outputs.size());
+        }
+    }
+}
+
+void Softmax::vote(const std::vector<std::unique_ptr<IDS::NXT::CNNv2::MultiBuffer>>& outputs,
+                   const QVector<OutputFormat>& formats,
+                   int classCount,
+                   ClassValues& values) {
+    values.fill(qMakePair(0, 0.), classCount);
+    for (auto cnt = 0; cnt < classCount; cnt++) {
+        values[cnt].first = cnt;
+    }
+
+    for (size_t member = 0; member < outputs.size(); member++) {
+        const auto format = formats.value(static_cast<int>(member));
+        const auto topClass = top(*outputs.at(member), classCount, format).first;
+        values[topClass].second += 1. / static_cast<double>(outputs.size());
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QPair>
+#include <QVector>
+
+#include <cnnmanager_v2.h>
+
+#include <memory>
+#include <vector>
+
+#include "outputformat.h"
+
+/**
+ * @brief Softmax evaluation of the output of classification CNNs
+ *
+ * The output buffer is read in its native element type. Dequantization is fused into the softmax, so no float
+ * copy of quantized outputs is created. The size of the buffer is checked against the element type and the class
+ * count before it is read.
+ */
+class Softmax {
+public:
+    /**
+     * @brief Pairs of class index and value
+     */
+    using ClassValues = QVector<QPair<int, double>>;
+
+    /**
+     * @brief Post-processing kernels for one class count
+     *
+     * The kernels of the common class counts 2, 3 and 10 are specialized at compile time, so their loops have a
+     * fixed bound and are unrolled. The kernels are selected once when a CNN gets activated, see kernels().
+     */
+    struct Kernels {
+        // same as Softmax::exponentials()
+        double (*exponentials)(const IDS::NXT::CNNv2::MultiBuffer& output,
+                               int classCount,
+                               ClassValues& values,
+                               const OutputFormat& format);
+        // same as Softmax::top()
+        QPair<int, double> (*top)(const IDS::NXT::CNNv2::MultiBuffer& output,
+                                  int classCount,
+                                  const OutputFormat& format);
+        // sorts the values of all classes by descending value
+        void (*sort)(ClassValues& values);
+        // same as exponentials for float logits which are not in an output buffer, e.g. of the benchmark
+        double (*logitExponentials)(const float* logits, int classCount, ClassValues& values);
+    };
+
+    /**
+     * @brief Selects the post-processing kernels for a class count
+     * @param classCount Number of classes
+     * @return Specialized kernels for 2, 3 and 10 classes, generic kernels for all other class counts
+     */
+    static const Kernels& kernels(int classCount);
+
+    /**
+     * @brief Checks that an output buffer holds one element per class
+     * @param elements Size of the output buffer as reported by the framework
+     * @param classCount Number of classes
+     *
+     * Throws a std::runtime_error if the size does not match, the buffer would be read out of bounds otherwise. The
+     * SDK headers do not state the unit of the buffer size. It is taken as the number of output elements, like the
+     * element pointer of the buffer suggests, so it does not depend on the output format.
+     */
+    static void validateOutputSize(qint64 elements, int classCount);
+
+    /**
+     * @brief Computes the exponentials of the CNN output
+     * @param output Output of a classification CNN
+     * @param classCount Number of classes
+     * @param values Pairs of class index and exponential, in class order
+     * @param format Element type and quantization of the output
+     * @return Sum of all exponentials, which is the softmax divisor
+     */
+    static double exponentials(const IDS::NXT::CNNv2::MultiBuffer& output,
+                               int classCount,
+                               ClassValues& values,
+                               const OutputFormat& format = OutputFormat{});
+
+    /**
+     * @brief Computes the class with the highest probability
+     * @param output Output of a classification CNN
+     * @param classCount Number of classes
+     * @param format Element type and quantization of the output
+     * @return Pair of class index and its probability
+     */
+    static QPair<int, double> top(const IDS::NXT::CNNv2::MultiBuffer& output,
+                                  int classCount,
+                                  const OutputFormat& format = OutputFormat{});
+
+    /**
+     * @brief Fuses the outputs of an ensemble by averaging their probabilities
+     * @param outputs Outputs of CNNs with the same classes
+     * @param formats Output formats in the same order as the outputs
+     * @param classCount Number of classes
+     * @param values Pairs of class index and averaged probability, in class order
+     */
+    static void average(const std::vector<std::unique_ptr<IDS::NXT::CNNv2::MultiBuffer>>& outputs,
+                        const QVector<OutputFormat>& formats,
+                        int classCount,
+                        ClassValues& values);
+
+    /**
+     * @brief Fuses the outputs of an ensemble by majority vote
+     * @param outputs Outputs of CNNs with the same classes
+     * @param formats Output formats in the same order as the outputs
+     * @param classCount Number of classes
+     * @param values Pairs of class index and share of the CNNs with this top-1 class, in class order
+     */
+    static void vote(const std::vector<std::unique_ptr<IDS::NXT::CNNv2::MultiBuffer>>& outputs,
+                     const QVector<OutputFormat>& formats,
+                     int classCount,
+                     ClassValues& values);
+};
@@ -0,0 +1,67 @@
+#include "temporalfilter.h"
+
+#include <algorithm>
+
+TemporalFilter::TemporalFilter(const Smoothing& smoothing)
+  : _smoothing{smoothing} {}
+
+int TemporalFilter::apply(Softmax::ClassValues& probabilities) {
+    const auto topClass = [&probabilities]() {
+        return std::max_element(probabilities.cbegin(),
+                                probabilities.cend(),
+                                [](const QPair<int, double>& lhs, const QPair<int, double>& rhs) {
+                                    return lhs.second < rhs.second;
+                                })
+               - probabilities.cbegin();
+    };
+
+    // a changed class count means the CNN changed, the old state is meaningless then
+    if (_classCount != probabilities.size()) {
+        _classCount = probabilities.size();
+        _average.clear();
+        _history.clear();
+        _historyPos = 0;
+        _decision = -1;
+    }
+
+    switch (_smoothing.mode) {
+    case Smoothing::Mode::Ema:
+        if (_average.isEmpty()) {
+            _average.resize(probabilities.size());
+            for (auto cnt = 0; cnt < probabilities.size(); cnt++) {
+                _average[cnt] = probabilities.at(cnt).second;
+            }
+        } else {
+            for (auto cnt = 0; cnt < probabilities.size(); cnt++) {
+                _average[cnt] += _smoothing.alpha * (probabilities.at(cnt).second - _average.at(cnt));
+            }
+        }
+        for (auto cnt = 0; cnt < probabilities.size(); cnt++) {
+            probabilities[cnt].second = _average.at(cnt);
+        }
+        _decision = static_cast<int>(topClass());
+        break;
+    case Smoothing::Mode::Hysteresis: {
+        const auto currentClass = static_cast<int>(topClass());
+        if (_history.size() < _smoothing.m) {
+            _history.append(currentClass);
+        } else {
+            _history[_historyPos] = currentClass;
+            _historyPos = (_historyPos + 1) % _smoothing.m;
+        }
+        if (_decision < 0 || std::count(_history.cbegin(), _history.cend(), currentClass) >= _smoothing.n) {
+            _decision = currentClass;
+        }
+        break;
+    }
+    default:
+        _decision = static_cast<int>(topClass());
+        break;
+    }
+
+    return _decision;
+}
+
+int TemporalFilter::decision() const {
+    return _decision;
+}
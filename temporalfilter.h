@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QVector>
+
+#include "cnnroiconfig.h"
+#include "softmax.h"
+
+/**
+ * @brief Temporal filter of the classification results of one ROI
+ *
+ * The filter smoothes the probabilities over consecutive frames or holds the decision until a new class is
+ * stable. The decision is the class which is reported as changed in publish on change mode.
+ */
+class TemporalFilter {
+public:
+    using Smoothing = CnnRoiConfig::CnnRoiMap::Smoothing;
+
+    TemporalFilter() = default;
+
+    /**
+     * @brief C'tor
+     * @param smoothing Filter configuration
+     */
+    explicit TemporalFilter(const Smoothing& smoothing);
+
+    /**
+     * @brief Filters the probabilities of a new frame
+     * @param probabilities Pairs of class index and probability in class order, replaced by the filtered ones
+     * @return Decided class index
+     */
+    int apply(Softmax::ClassValues& probabilities);
+
+    /**
+     * @brief Getter for the decision of the last frame
+     * @return Class index, -1 if no frame was filtered yet
+     */
+    int decision() const;
+
+private:
+    Smoothing _smoothing;
+    int _classCount = 0;
+    QVector<double> _average;
+    QVector<int> _history;
+    int _historyPos = 0;
+    int _decision = -1;
+};
@@ -0,0 +1,23 @@
+CONFIG += c++17 testcase console
+CONFIG -= app_bundle
+QT += testlib gui
+
+TARGET = tst_benchmark
+INCLUDEPATH += ../mock ../..
+
+SOURCES += tst_benchmark.cpp \
+    ../../cnnclasstable.cpp \
+    ../../cnnroiconfig.cpp \
+    ../../imagepreprocessor.cpp \
+    ../../myresultimage.cpp \
+    ../../outputformat.cpp \
+    ../../softmax.cpp
+HEADERS += ../../cnnclasstable.h \
+    ../../cnnroiconfig.h \
+    ../../imagepreprocessor.h \
+    ../../myresultimage.h \
+    ../../outputformat.h \
+    ../../softmax.h \
+    ../mock/cnnmanager_v2.h \
+    ../mock/image.h \
+    ../mock/resultimage.h
@@ -0,0 +1,248 @@
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "cnnclasstable.h"
+#include "cnnroiconfig.h"
+#include "imagepreprocessor.h"
+#include "myresultimage.h"
+#include "softmax.h"
+
+Q_DECLARE_METATYPE(QImage::Format)
+
+/**
+ * @brief Micro-benchmark of the hot path components which do not need the NXT framework
+ *
+ * Every component is measured in isolation with synthetic inputs by QBENCHMARK: loading the configuration, validating
+ * ROI maps, cropping and scaling every supported pixel format compared with the former path by QImage, softmax and
+ * sort, the JSON serialization and setting the result image with its overlay. The parameter of a case, e.g. the
+ * number of ROIs, is its data tag.
+ */
+class TestBenchmark : public QObject {
+    Q_OBJECT
+
+private:
+    static const QSize SENSOR_SIZE;
+    static const QRect ROI_RECT;
+    static const QSize CNN_INPUT_SIZE;
+
+    QTemporaryDir _dir;
+
+    static std::shared_ptr<const CnnClassTable> classTable(int classCount) {
+        QStringList classes;
+        for (auto cnt = 0; cnt < classCount; cnt++) {
+            classes.append(QStringLiteral("Class%1").arg(cnt));
+        }
+
+        return std::make_shared<const CnnClassTable>(classes);
+    }
+
+    static QVariantList roiMaps(int roiCount) {
+        QVariantList maps;
+        for (auto roi = 0; roi < roiCount; roi++) {
+            maps.append(CnnRoiConfig::CnnRoiMap(QStringLiteral("roi_%1").arg(roi),
+                                                QStringLiteral("cnn_%1").arg(roi % 4),
+                                                ROI_RECT.translated(roi % 10, roi % 7))
+                            .toMap());
+        }
+
+        return maps;
+    }
+
+    static void addCountRows(std::initializer_list<int> counts) {
+        QTest::addColumn<int>("count");
+        for (const auto count : counts) {
+            QTest::newRow(QByteArray::number(count).constData()) << count;
+        }
+    }
+
+    static void addFormatRows() {
+        QTest::addColumn<QImage::Format>("format");
+        QTest::newRow("Mono") << QImage::Format_Mono;
+        QTest::newRow("MonoLSB") << QImage::Format_MonoLSB;
+        QTest::newRow("Grayscale8") << QImage::Format_Grayscale8;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+        QTest::newRow("Grayscale16") << QImage::Format_Grayscale16;
+#endif
+        QTest::newRow("Indexed8") << QImage::Format_Indexed8;
+        QTest::newRow("RGB888") << QImage::Format_RGB888;
+        QTest::newRow("RGB32") << QImage::Format_RGB32;
+        QTest::newRow("ARGB32") << QImage::Format_ARGB32;
+        QTest::newRow("ARGB32_Premultiplied") << QImage::Format_ARGB32_Premultiplied;
+        QTest::newRow("RGBX8888") << QImage::Format_RGBX8888;
+        QTest::newRow("RGBA8888") << QImage::Format_RGBA8888;
+    }
+
+    /**
+     * @brief Sensor image in the given format, a gradient so the conversions do not produce uniform images
+     */
+    static QImage sensorImage(QImage::Format format) {
+        QImage gradient(SENSOR_SIZE, QImage::Format_RGB32);
+        for (auto y = 0; y < gradient.height(); y++) {
+            auto* line = reinterpret_cast<QRgb*>(gradient.scanLine(y));
+            for (auto x = 0; x < gradient.width(); x++) {
+                line[x] = qRgb(x & 0xff, y & 0xff, (x + y) & 0xff);
+            }
+        }
+
+        return gradient.convertToFormat(format);
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(_dir.isValid());
+    }
+
+    void loadJsonFile_data() {
+        // more than the supported ROIs are rejected by the loader, larger maps are covered by loadMap
+        addCountRows({CnnRoiConfig::getMaxRois()});
+    }
+
+    void loadJsonFile() {
+        QFETCH(int, count);
+        QJsonArray rois;
+        for (const auto& map : roiMaps(count)) {
+            rois.append(QJsonObject::fromVariantMap(map.toMap()));
+        }
+        const auto fileName = _dir.filePath(QStringLiteral("config_%1.json").arg(count));
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QJsonDocument(rois).toJson());
+        file.close();
+
+        QBENCHMARK {
+            CnnRoiConfig config;
+            config.loadJsonFile(fileName);
+        }
+    }
+
+    void loadMap_data() {
+        addCountRows({20, 200, 2000});
+    }
+
+    void loadMap() {
+        QFETCH(int, count);
+        const auto maps = roiMaps(count);
+
+        CnnRoiConfig::CnnRoiMap cnnRoi{QString{}, QString{}, QRect{}};
+        QBENCHMARK {
+            for (const auto& map : maps) {
+                cnnRoi.loadMap(map.toMap());
+            }
+        }
+    }
+
+    void cropAndScale_data() {
+        addFormatRows();
+    }
+
+    void cropAndScale() {
+        QFETCH(QImage::Format, format);
+        const auto source = sensorImage(format);
+        QImage target(CNN_INPUT_SIZE, ImagePreprocessor::targetFormat(format));
+
+        QBENCHMARK {
+            ImagePreprocessor::cropAndScale(source, ROI_RECT, target);
+        }
+    }
+
+    void copyAndScaled_data() {
+        addFormatRows();
+    }
+
+    /**
+     * @brief The former path by QImage, for comparison with cropAndScale
+     */
+    void copyAndScaled() {
+        QFETCH(QImage::Format, format);
+        const auto source = sensorImage(format);
+        QImage target;
+
+        QBENCHMARK {
+            target = source.copy(ROI_RECT).scaled(CNN_INPUT_SIZE);
+        }
+    }
+
+    void softmaxAndSort_data() {
+        addCountRows({2, 3, 10, 100, 1000});
+    }
+
+    void softmaxAndSort() {
+        QFETCH(int, count);
+        std::mt19937 generator;
+        std::uniform_real_distribution<float> distribution(-8.f, 8.f);
+        std::vector<float> logits(count);
+        for (auto& logit : logits) {
+            logit = distribution(generator);
+        }
+        const auto& kernels = Softmax::kernels(count);
+
+        Softmax::ClassValues values;
+        QBENCHMARK {
+            kernels.logitExponentials(logits.data(), count, values);
+            kernels.sort(values);
+        }
+    }
+
+    void resultToJson_data() {
+        addCountRows({2, 10, 1000});
+    }
+
+    void resultToJson() {
+        QFETCH(int, count);
+        const auto classes = classTable(count);
+        Softmax::ClassValues values;
+        for (auto cnt = 0; cnt < count; cnt++) {
+            values.append(qMakePair(cnt, 1. / (cnt + 1)));
+        }
+
+        QByteArray output;
+        QBENCHMARK {
+            output.clear();
+            classes->appendJson(output, values, 2., true);
+        }
+    }
+
+    void setImageWithOverlay_data() {
+        addCountRows({1, 5, 20});
+    }
+
+    void setImageWithOverlay() {
+        QFETCH(int, count);
+        QImage image(SENSOR_SIZE, QImage::Format_Grayscale8);
+        image.fill(128);
+        const auto classes = classTable(2);
+        QList<MyResultImage::overlayData> overlay;
+        for (auto roi = 0; roi < count; roi++) {
+            MyResultImage::overlayData data;
+            data.classes = classes;
+            data.classIndex = roi % 2;
+            data.probability = 0.9f;
+            data.roi = QRect((roi % 5) * 360, (roi / 5) * 280, 320, 240);
+            overlay.append(data);
+        }
+        const auto nxtImage = std::make_shared<IDS::NXT::Hardware::Image>(QStringLiteral("image"));
+
+        MyResultImage resultImage("resultimage");
+        QBENCHMARK {
+            resultImage.setImageWithOverlay(image, nxtImage, overlay);
+        }
+        QCOMPARE(resultImage.getImage().size(), SENSOR_SIZE);
+    }
+};
+
+const QSize TestBenchmark::SENSOR_SIZE{1920, 1200};
+const QRect TestBenchmark::ROI_RECT{50, 120, 850, 450};
+const QSize TestBenchmark::CNN_INPUT_SIZE{224, 224};
+
+QTEST_MAIN(TestBenchmark)
+
+#include "tst_benchmark.moc"
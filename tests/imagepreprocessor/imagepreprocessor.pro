@@ -0,0 +1,10 @@
+CONFIG += c++17 testcase console
+CONFIG -= app_bundle
+QT += testlib gui
+
+TARGET = tst_imagepreprocessor
+INCLUDEPATH += ../..
+
+SOURCES += tst_imagepreprocessor.cpp \
+    ../../imagepreprocessor.cpp
+HEADERS += ../../imagepreprocessor.h
@@ -0,0 +1,167 @@
+#include <QImage>
+#include <QtTest>
+
+#include <cmath>
+
+#include "imagepreprocessor.h"
+
+Q_DECLARE_METATYPE(QImage::Format)
+
+/**
+ * @brief Bit-exact check of the one-pass cropping and scaling
+ *
+ * The reference samples every target pixel on its own through the pixel accessors of QImage, so it shares neither
+ * the coordinate mapping nor the scanline access with ImagePreprocessor. Both have to agree on every pixel for every
+ * supported source format, including ROIs at the image border and up- and downscaling.
+ */
+class TestImagePreprocessor : public QObject {
+    Q_OBJECT
+
+private:
+    static const QSize SOURCE_SIZE;
+
+    struct Case {
+        QRect roi;
+        QSize size;
+    };
+
+    static QList<Case> cases() {
+        return {{QRect(QPoint(0, 0), SOURCE_SIZE), SOURCE_SIZE},
+                {QRect(13, 7, 250, 150), QSize(224, 224)},
+                {QRect(300, 190, 20, 10), QSize(64, 48)},
+                {QRect(1, 1, 33, 17), QSize(7, 5)}};
+    }
+
+    /**
+     * @brief Source image without uniform areas, with varying alpha for the formats with alpha channel
+     */
+    static QImage sourceImage(QImage::Format format) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+        if (format == QImage::Format_Grayscale16) {
+            QImage image(SOURCE_SIZE, format);
+            for (auto y = 0; y < image.height(); y++) {
+                auto* line = reinterpret_cast<quint16*>(image.scanLine(y));
+                for (auto x = 0; x < image.width(); x++) {
+                    line[x] = static_cast<quint16>(x * 131 + y * 17);
+                }
+            }
+            return image;
+        }
+#endif
+        QImage image(SOURCE_SIZE, QImage::Format_ARGB32);
+        for (auto y = 0; y < image.height(); y++) {
+            auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+            for (auto x = 0; x < image.width(); x++) {
+                line[x] = qRgba(x & 0xff, y & 0xff, (x * 3 + y) & 0xff, (x * 7 + y * 3) & 0xff);
+            }
+        }
+        return image.convertToFormat(format);
+    }
+
+    /**
+     * @brief Expected color of a target pixel
+     * @return Color without alpha, the targets are opaque
+     */
+    static QRgb referencePixel(const QImage& source, const QRect& roi, const QSize& size, int x, int y) {
+        // the pixel center of the target mapped onto the ROI
+        const auto sourceX = roi.x() + static_cast<int>(std::floor((x + 0.5) * roi.width() / size.width()));
+        const auto sourceY = roi.y() + static_cast<int>(std::floor((y + 0.5) * roi.height() / size.height()));
+
+        switch (source.format()) {
+        case QImage::Format_Mono:
+        case QImage::Format_MonoLSB: {
+            const auto gray = qGray(source.pixel(sourceX, sourceY));
+            return qRgb(gray, gray, gray);
+        }
+        case QImage::Format_ARGB32_Premultiplied: {
+            // pixel() returns the premultiplied value for this format
+            const auto color = qUnpremultiply(source.pixel(sourceX, sourceY));
+            return qRgb(qRed(color), qGreen(color), qBlue(color));
+        }
+        default: {
+            // also Grayscale16, pixel() reduces it to 8 bit like the conversion by QImage
+            const auto color = source.pixel(sourceX, sourceY);
+            return qRgb(qRed(color), qGreen(color), qBlue(color));
+        }
+        }
+    }
+
+    static int referenceIndex(const QImage& source, const QRect& roi, const QSize& size, int x, int y) {
+        const auto sourceX = roi.x() + static_cast<int>(std::floor((x + 0.5) * roi.width() / size.width()));
+        const auto sourceY = roi.y() + static_cast<int>(std::floor((y + 0.5) * roi.height() / size.height()));
+        return source.pixelIndex(sourceX, sourceY);
+    }
+
+private slots:
+    void cropAndScale_data() {
+        QTest::addColumn<QImage::Format>("format");
+        QTest::newRow("Mono") << QImage::Format_Mono;
+        QTest::newRow("MonoLSB") << QImage::Format_MonoLSB;
+        QTest::newRow("Grayscale8") << QImage::Format_Grayscale8;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+        QTest::newRow("Grayscale16") << QImage::Format_Grayscale16;
+#endif
+        QTest::newRow("Indexed8") << QImage::Format_Indexed8;
+        QTest::newRow("RGB888") << QImage::Format_RGB888;
+        QTest::newRow("RGB32") << QImage::Format_RGB32;
+        QTest::newRow("ARGB32") << QImage::Format_ARGB32;
+        QTest::newRow("ARGB32_Premultiplied") << QImage::Format_ARGB32_Premultiplied;
+        QTest::newRow("RGBX8888") << QImage::Format_RGBX8888;
+        QTest::newRow("RGBA8888") << QImage::Format_RGBA8888;
+    }
+
+    void cropAndScale() {
+        QFETCH(QImage::Format, format);
+        const auto source = sourceImage(format);
+        QCOMPARE(source.format(), format);
+        QVERIFY(ImagePreprocessor::isSupported(format));
+        const auto targetFormat = ImagePreprocessor::targetFormat(format);
+
+        for (const auto& testCase : cases()) {
+            // a target in another format is reallocated, one in the target format is reused
+            QImage target(testCase.size, QImage::Format_RGB16);
+            ImagePreprocessor::cropAndScale(source, testCase.roi, target);
+            QCOMPARE(target.format(), targetFormat);
+            QCOMPARE(target.size(), testCase.size);
+            const auto* bits = target.constBits();
+            ImagePreprocessor::cropAndScale(source, testCase.roi, target);
+            QCOMPARE(target.constBits(), bits);
+
+            for (auto y = 0; y < target.height(); y++) {
+                for (auto x = 0; x < target.width(); x++) {
+                    if (targetFormat == QImage::Format_Indexed8) {
+                        QCOMPARE(target.pixelIndex(x, y), referenceIndex(source, testCase.roi, testCase.size, x, y));
+                    } else {
+                        const auto color = target.pixel(x, y);
+                        QCOMPARE(qRgb(qRed(color), qGreen(color), qBlue(color)),
+                                 referencePixel(source, testCase.roi, testCase.size, x, y));
+                    }
+                }
+            }
+        }
+    }
+
+    void unsupportedFormatFallsBack() {
+        const auto source = sourceImage(QImage::Format_RGB16);
+        QVERIFY(!ImagePreprocessor::isSupported(source.format()));
+        for (const auto& testCase : cases()) {
+            QImage target(testCase.size, QImage::Format_RGB888);
+            ImagePreprocessor::cropAndScale(source, testCase.roi, target);
+            QCOMPARE(target, source.copy(testCase.roi).scaled(testCase.size));
+        }
+    }
+
+    void roiOutsideFallsBack() {
+        const auto source = sourceImage(QImage::Format_Grayscale8);
+        const QRect roi(300, 190, 40, 20);
+        QImage target(QSize(16, 8), QImage::Format_Grayscale8);
+        ImagePreprocessor::cropAndScale(source, roi, target);
+        QCOMPARE(target, source.copy(roi).scaled(QSize(16, 8)));
+    }
+};
+
+const QSize TestImagePreprocessor::SOURCE_SIZE{320, 200};
+
+QTEST_APPLESS_MAIN(TestImagePreprocessor)
+
+#include "tst_imagepreprocessor.moc"
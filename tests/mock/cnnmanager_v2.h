@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QVector>
+
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Stand-in for the output buffers of the NXT SDK
+ *
+ * Only the part used by the post-processing is mirrored, so it can be tested on a desktop without the SDK. The
+ * buffers do not own their data, the test keeps it alive.
+ */
+namespace IDS {
+namespace NXT {
+namespace CNNv2 {
+
+struct Buffer {
+    float* data = nullptr;
+    size_t size = 0;
+};
+
+class MultiBuffer {
+public:
+    explicit MultiBuffer(QVector<Buffer> buffers = {})
+      : _buffers{std::move(buffers)} {}
+
+    const QVector<Buffer>& allBuffers() const {
+        return _buffers;
+    }
+
+private:
+    QVector<Buffer> _buffers;
+};
+
+} // namespace CNNv2
+} // namespace NXT
+} // namespace IDS
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QString>
+
+#include <utility>
+
+/**
+ * @brief Stand-in for the camera images of the NXT SDK
+ *
+ * Only the key is mirrored, which the result image needs to report a modification. The test sets it directly.
+ */
+namespace IDS {
+namespace NXT {
+namespace Hardware {
+
+class Image {
+public:
+    explicit Image(QString key = QString())
+      : _key{std::move(key)} {}
+
+    QString key() const {
+        return _key;
+    }
+
+private:
+    QString _key;
+};
+
+} // namespace Hardware
+} // namespace NXT
+} // namespace IDS
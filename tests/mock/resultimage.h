@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QObject>
+#include <QString>
+
+/**
+ * @brief Stand-in for the result images of the NXT SDK
+ *
+ * Only the part used by MyResultImage is mirrored, so it can be tested on a desktop without the SDK. The modification
+ * is only recorded, there is no framework to notify.
+ */
+namespace IDS {
+namespace NXT {
+
+class ResultImage : public QObject {
+public:
+    explicit ResultImage(const QByteArray& name)
+      : _name{name} {}
+
+    virtual QImage getImage() const = 0;
+
+    QString modified() const {
+        return _modified;
+    }
+
+protected:
+    void setModified(const QString& key) {
+        _modified = key;
+    }
+
+private:
+    QByteArray _name;
+    QString _modified;
+};
+
+} // namespace NXT
+} // namespace IDS
@@ -0,0 +1,10 @@
+CONFIG += c++17 testcase console sanitizer sanitize_thread
+CONFIG -= app_bundle
+QT += testlib
+QT -= gui
+
+TARGET = tst_rcupointer
+INCLUDEPATH += ../..
+
+SOURCES += tst_rcupointer.cpp
+HEADERS += ../../rcupointer.h
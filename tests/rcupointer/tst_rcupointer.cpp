@@ -0,0 +1,123 @@
+#include <QRect>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QtTest>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rcupointer.h"
+
+/**
+ * @brief Stress test of the configuration publication under ThreadSanitizer
+ *
+ * The writer republishes the AOI and the ROI list the way the CNN/ROI handler does on every configuration change,
+ * while reader threads take snapshots the way the engines set up their vision objects for every frame. Every
+ * snapshot must be complete and the AOI must never be older than the list read before it. The races themselves
+ * are reported by ThreadSanitizer, the project is built with it.
+ *
+ * The test covers the RcuPointer template with stand-in types only. CnnRoiHandler::publishActiveRoiCnnList and the
+ * snapshots of MyEngine depend on the configurables and the CNN manager of the SDK, so they are not run here.
+ */
+class TestRcuPointer : public QObject {
+    Q_OBJECT
+
+private:
+    struct RoiEntry {
+        QString name;
+        QRect roi;
+        int generation;
+    };
+    using RoiList = QVector<RoiEntry>;
+
+    struct Aoi {
+        QRect rect;
+        int generation = 0;
+    };
+
+    static constexpr int ROI_COUNT = 20;
+    static constexpr int PUBLICATIONS = 20000;
+
+    static std::shared_ptr<const RoiList> makeList(int generation) {
+        RoiList list;
+        for (auto roi = 0; roi < ROI_COUNT; roi++) {
+            list.append(RoiEntry{QStringLiteral("roi_%1").arg(roi), QRect(roi, generation % 100, 64, 48), generation});
+        }
+        return std::make_shared<const RoiList>(std::move(list));
+    }
+
+private slots:
+    void initialSnapshot() {
+        RcuPointer<const RoiList> list;
+        QVERIFY(list.load());
+        QVERIFY(list.load()->isEmpty());
+
+        RcuPointer<const Aoi> empty{nullptr};
+        QVERIFY(!empty.load());
+    }
+
+    void snapshotOutlivesPublication() {
+        RcuPointer<const RoiList> list{makeList(1)};
+        const auto snapshot = list.load();
+        list.store(makeList(2));
+        QCOMPARE(snapshot->first().generation, 1);
+        QCOMPARE(list.load()->first().generation, 2);
+    }
+
+    void configChangesAtFrameRate() {
+        RcuPointer<const RoiList> list{makeList(0)};
+        RcuPointer<const Aoi> aoi{std::make_shared<const Aoi>()};
+        std::atomic_bool stop{false};
+        std::atomic_int torn{0};
+        std::atomic_int stale{0};
+        std::atomic_int reordered{0};
+
+        const auto readerCount = std::max(2, QThread::idealThreadCount());
+        std::vector<std::thread> readers;
+        for (auto reader = 0; reader < readerCount; reader++) {
+            readers.emplace_back([&]() {
+                auto lastGeneration = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const auto snapshot = list.load();
+                    const auto aoiSnapshot = aoi.load();
+                    const auto generation = snapshot->first().generation;
+                    for (const auto& entry : *snapshot) {
+                        if (entry.generation != generation || entry.roi.y() != generation % 100) {
+                            torn++;
+                        }
+                    }
+                    if (generation < lastGeneration) {
+                        reordered++;
+                    }
+                    if (aoiSnapshot->generation < generation) {
+                        stale++;
+                    }
+                    lastGeneration = generation;
+                }
+            });
+        }
+
+        for (auto generation = 1; generation <= PUBLICATIONS; generation++) {
+            // the AOI is published first, so a reader of the new list never sees the old AOI
+            aoi.store(std::make_shared<const Aoi>(Aoi{QRect(0, 0, generation, generation), generation}));
+            list.store(makeList(generation));
+        }
+        stop = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        QCOMPARE(torn.load(), 0);
+        QCOMPARE(stale.load(), 0);
+        QCOMPARE(reordered.load(), 0);
+        QCOMPARE(list.load()->first().generation, PUBLICATIONS);
+    }
+};
+
+QTEST_APPLESS_MAIN(TestRcuPointer)
+
+#include "tst_rcupointer.moc"
@@ -0,0 +1,14 @@
+CONFIG += c++17 testcase console
+CONFIG -= app_bundle
+QT += testlib
+QT -= gui
+
+TARGET = tst_softmax
+INCLUDEPATH += ../mock ../..
+
+SOURCES += tst_softmax.cpp \
+    ../../softmax.cpp \
+    ../../outputformat.cpp
+HEADERS += ../../softmax.h \
+    ../../outputformat.h \
+    ../mock/cnnmanager_v2.h
@@ -0,0 +1,160 @@
+#include <QVariantMap>
+#include <QtTest>
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "softmax.h"
+
+/**
+ * @brief Decoding of the output buffers against a float reference
+ *
+ * Every output format is encoded from known logits, so the exponentials and the top class of the specialized and
+ * the generic kernels can be compared with the ones computed from the logits directly.
+ */
+class TestSoftmax : public QObject {
+    Q_OBJECT
+
+private:
+    /**
+     * @brief Encoded output buffer together with the logits it represents
+     */
+    struct Output {
+        OutputFormat format;
+        std::vector<unsigned char> bytes;
+        std::vector<double> logits;
+
+        IDS::NXT::CNNv2::MultiBuffer buffer() {
+            return IDS::NXT::CNNv2::MultiBuffer{{{reinterpret_cast<float*>(bytes.data()), logits.size()}}};
+        }
+    };
+
+    template <typename Element>
+    static void append(Output& output, Element element, double logit) {
+        const auto pos = output.bytes.size();
+        output.bytes.resize(pos + sizeof(element));
+        std::memcpy(&output.bytes[pos], &element, sizeof(element));
+        output.logits.push_back(logit);
+    }
+
+    /**
+     * @brief Encodes a value which is exactly representable as normal half precision value
+     */
+    static quint16 floatToHalf(double value) {
+        if (value == 0.) {
+            return 0;
+        }
+        int exponent;
+        const auto mantissa = std::frexp(std::abs(value), &exponent); // in [0.5, 1)
+        const auto sign = value < 0. ? 0x8000u : 0u;
+        return static_cast<quint16>(sign | static_cast<unsigned>(exponent + 14) << 10
+                                    | static_cast<unsigned>((mantissa * 2. - 1.) * 1024.));
+    }
+
+    static Output native(int classCount) {
+        Output output;
+        for (auto cnt = 0; cnt < classCount; cnt++) {
+            const auto logit = static_cast<float>((cnt * 7 % 11) * 0.375 - 2.);
+            append(output, logit, static_cast<double>(logit));
+        }
+        return output;
+    }
+
+    static Output float16(int classCount) {
+        Output output{OutputFormat{QVariantMap{{"Type", "Float16"}}}, {}, {}};
+        for (auto cnt = 0; cnt < classCount; cnt++) {
+            if (cnt == classCount - 1) {
+                // the smallest subnormal value
+                append(output, static_cast<quint16>(0x0001), std::ldexp(1., -24));
+                continue;
+            }
+            const auto logit = ((cnt * 5) % 9 - 4) * 0.5;
+            append(output, floatToHalf(logit), logit);
+        }
+        return output;
+    }
+
+    static Output int8(int classCount) {
+        Output output{OutputFormat{QVariantMap{{"Type", "Int8"}, {"Scale", 0.0625}, {"ZeroPoint", -3}}}, {}, {}};
+        for (auto cnt = 0; cnt < classCount; cnt++) {
+            const auto value = static_cast<qint8>((cnt * 37) % 256 - 128);
+            append(output, value, 0.0625 * (value + 3));
+        }
+        return output;
+    }
+
+    static Output uint8(int classCount) {
+        Output output{OutputFormat{QVariantMap{{"Type", "UInt8"}, {"Scale", 0.03125}, {"ZeroPoint", 128}}}, {}, {}};
+        for (auto cnt = 0; cnt < classCount; cnt++) {
+            const auto value = static_cast<quint8>((cnt * 53) % 256);
+            append(output, value, 0.03125 * (value - 128));
+        }
+        return output;
+    }
+
+    static void compare(Output output, int classCount) {
+        const auto buffer = output.buffer();
+
+        // reference from the logits
+        auto referenceSum = 0.;
+        auto referenceTop = 0;
+        for (auto cnt = 0; cnt < classCount; cnt++) {
+            referenceSum += std::exp(output.logits.at(cnt));
+            if (output.logits.at(cnt) > output.logits.at(referenceTop)) {
+                referenceTop = cnt;
+            }
+        }
+
+        for (const auto* kernels : {&Softmax::kernels(classCount), &Softmax::kernels(0)}) {
+            Softmax::ClassValues values;
+            const auto expSum = kernels->exponentials(buffer, classCount, values, output.format);
+            QCOMPARE(values.size(), classCount);
+            QCOMPARE(expSum, referenceSum);
+            for (auto cnt = 0; cnt < classCount; cnt++) {
+                QCOMPARE(values.at(cnt).first, cnt);
+                QCOMPARE(values.at(cnt).second, std::exp(output.logits.at(cnt)));
+            }
+
+            const auto top = kernels->top(buffer, classCount, output.format);
+            QCOMPARE(top.first, referenceTop);
+            QCOMPARE(top.second, std::exp(output.logits.at(referenceTop)) / referenceSum);
+        }
+    }
+
+private slots:
+    void decode_data() {
+        QTest::addColumn<int>("classCount");
+        for (const auto classCount : {2, 3, 7, 10, 100}) {
+            QTest::newRow(QByteArray::number(classCount)) << classCount;
+        }
+    }
+
+    void decode() {
+        QFETCH(int, classCount);
+        compare(native(classCount), classCount);
+        compare(float16(classCount), classCount);
+        compare(int8(classCount), classCount);
+        compare(uint8(classCount), classCount);
+    }
+
+    void rejectsBufferSizeMismatch() {
+        // a buffer read as more or less classes than it holds
+        auto output = native(10);
+        const auto buffer = output.buffer();
+        Softmax::ClassValues values;
+        QVERIFY_EXCEPTION_THROWN(Softmax::exponentials(buffer, 11, values), std::runtime_error);
+        QVERIFY_EXCEPTION_THROWN(Softmax::kernels(3).top(buffer, 3, output.format), std::runtime_error);
+        QVERIFY_EXCEPTION_THROWN(Softmax::kernels(100).exponentials(buffer, 100, values, output.format),
+                                 std::runtime_error);
+
+        QVERIFY_EXCEPTION_THROWN(Softmax::validateOutputSize(40, 10), std::runtime_error);
+        QVERIFY_EXCEPTION_THROWN(Softmax::validateOutputSize(9, 10), std::runtime_error);
+        Softmax::validateOutputSize(10, 10);
+    }
+};
+
+QTEST_APPLESS_MAIN(TestSoftmax)
+
+#include "tst_softmax.moc"
@@ -0,0 +1,5 @@
+TEMPLATE = subdirs
+SUBDIRS += rcupointer \
+    softmax \
+    imagepreprocessor \
+    benchmark
@@ -0,0 +1,197 @@
+#include "trace.h"
+
+#include <QFile>
+#include <QLoggingCategory>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static QLoggingCategory lc{"multicnnclassifier.trace"};
+
+static constexpr size_t EVENTS_PER_THREAD = 4096;
+static constexpr qint64 DEADLINE_WRITE_INTERVAL_MS = 1000;
+
+std::atomic_bool Trace::_enabled{false};
+
+namespace {
+/**
+ * @brief Slot of a ring buffer, guarded like a seqlock
+ *
+ * The fields are atomics, so an export while the owning thread overwrites the slot is no data race. The sequence
+ * holds the number of the event plus one, 0 while the slot is written. A reader keeps the fields only if the
+ * sequence is the expected one before and after reading them.
+ */
+struct Slot {
+    std::atomic<quint64> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<qint64> startNs{0};
+    std::atomic<qint64> durationNs{0};
+    std::atomic_int arg{-1};
+};
+
+/**
+ * @brief Ring buffer of one thread
+ *
+ * Only the owning thread writes. The head counts all events ever recorded, readers take it with acquire
+ * semantics and drop the slots which were overwritten meanwhile.
+ */
+struct ThreadBuffer {
+    int threadId = 0;
+    std::array<Slot, EVENTS_PER_THREAD> slots;
+    std::atomic<quint64> head{0};
+};
+
+struct Registry {
+    std::mutex lock;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::atomic<qint64> clearedNs{0};
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+ThreadBuffer& threadBuffer() {
+    // the buffer stays registered after the thread ended, so its events can still be exported
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto newBuffer = std::make_shared<ThreadBuffer>();
+        auto& reg = registry();
+        std::lock_guard<std::mutex> locker(reg.lock);
+        newBuffer->threadId = static_cast<int>(reg.buffers.size()) + 1;
+        reg.buffers.push_back(newBuffer);
+        return newBuffer;
+    }();
+
+    return *buffer;
+}
+} // namespace
+
+void Trace::setEnabled(bool enable) {
+    _enabled.store(enable, std::memory_order_relaxed);
+}
+
+qint64 Trace::now() {
+    static const QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+
+    return clock.nsecsElapsed();
+}
+
+void Trace::record(const char* name, qint64 startNs, qint64 durationNs, int arg) {
+    auto& buffer = threadBuffer();
+    const auto index = buffer.head.load(std::memory_order_relaxed);
+    auto& slot = buffer.slots[index % EVENTS_PER_THREAD];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(durationNs, std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+    buffer.head.store(index + 1, std::memory_order_release);
+}
+
+QByteArray Trace::toChromeJson() {
+    auto& reg = registry();
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> locker(reg.lock);
+        buffers = reg.buffers;
+    }
+    const auto clearedNs = reg.clearedNs.load();
+
+    QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    auto first = true;
+    for (const auto& buffer : buffers) {
+        const auto head = buffer->head.load(std::memory_order_acquire);
+        const auto begin = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+
+        for (auto index = begin; index < head; index++) {
+            // events overwritten while reading are dropped
+            const auto& slot = buffer->slots[index % EVENTS_PER_THREAD];
+            if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+                continue;
+            }
+            const Event event{slot.name.load(std::memory_order_relaxed),
+                              slot.startNs.load(std::memory_order_relaxed),
+                              slot.durationNs.load(std::memory_order_relaxed),
+                              slot.arg.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != index + 1) {
+                continue;
+            }
+            if (!event.name || event.startNs < clearedNs) {
+                continue;
+            }
+            if (!first) {
+                json.append(',');
+            }
+            first = false;
+            json.append("{\"name\":\"");
+            json.append(event.name);
+            json.append("\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+            json.append(QByteArray::number(buffer->threadId));
+            json.append(",\"ts\":");
+            json.append(QByteArray::number(static_cast<double>(event.startNs) / 1000., 'f', 3));
+            json.append(",\"dur\":");
+            json.append(QByteArray::number(static_cast<double>(event.durationNs) / 1000., 'f', 3));
+            if (event.arg >= 0) {
+                json.append(",\"args\":{\"roi\":");
+                json.append(QByteArray::number(event.arg));
+                json.append('}');
+            }
+            json.append('}');
+        }
+    }
+    json.append("]}");
+
+    return json;
+}
+
+void Trace::clear() {
+    registry().clearedNs.store(now());
+}
+
+TraceRecorder::TraceRecorder()
+  : _tracing{"tracing", false}
+  , _traceFile{"tracefile", false, true, "json"} {
+    _traceFile.setZIndex(2);
+    _traceFile.setFilter({"Json |*.json"});
+    connect(&_tracing, &IDS::NXT::ConfigurableBool::changed, this, &TraceRecorder::enableTracing);
+}
+
+void TraceRecorder::deadlineMissed() {
+    if (!Trace::enabled() || (_lastWrite.isValid() && _lastWrite.elapsed() < DEADLINE_WRITE_INTERVAL_MS)) {
+        return;
+    }
+    writeTrace();
+}
+
+void TraceRecorder::enableTracing(bool enable) {
+    if (enable) {
+        Trace::clear();
+        Trace::setEnabled(true);
+    } else {
+        Trace::setEnabled(false);
+        writeTrace();
+    }
+}
+
+void TraceRecorder::writeTrace() {
+    _lastWrite.start();
+
+    QFile file(_traceFile.absoluteFilePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lc) << "Can not write trace to" << file.fileName();
+        return;
+    }
+    file.write(Trace::toChromeJson());
+    file.close();
+    qCDebug(lc) << "Trace written to" << file.fileName();
+}
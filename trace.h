@@ -0,0 +1,137 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <atomic>
+
+#include <configurablebool.h>
+#include <configurablefile.h>
+
+/**
+ * @brief Flight recorder for spans of the image processing
+ *
+ * Every thread records into an own ring buffer of fixed-size events, so recording needs neither a lock nor an
+ * allocation. The latest events of all threads can be exported in the Chrome trace format, which is shown by
+ * chrome://tracing and Perfetto. If tracing is disabled, a span costs one relaxed atomic load.
+ */
+class Trace {
+public:
+    /**
+     * @brief Recorded span
+     */
+    struct Event {
+        const char* name = nullptr; // string literal, it is not copied
+        qint64 startNs = 0;
+        qint64 durationNs = 0;
+        int arg = -1; // e.g. the index of a ROI, -1 if not used
+    };
+
+    /**
+     * @brief Records the lifetime of the object as span
+     */
+    class Span {
+    public:
+        /**
+         * @brief C'tor
+         * @param name Name of the span, must be a string literal
+         * @param arg Optional argument, e.g. the index of a ROI
+         */
+        explicit Span(const char* name, int arg = -1)
+          : _name{Trace::enabled() ? name : nullptr}
+          , _arg{arg}
+          , _startNs{_name ? Trace::now() : 0} {}
+
+        ~Span() {
+            if (_name) {
+                Trace::record(_name, _startNs, Trace::now() - _startNs, _arg);
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* _name;
+        int _arg;
+        qint64 _startNs;
+    };
+
+    /**
+     * @brief Getter for the recording state
+     * @return True if spans are recorded
+     */
+    static bool enabled() {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Setter for the recording state
+     * @param enable Flag to enable/disable the recording
+     */
+    static void setEnabled(bool enable);
+
+    /**
+     * @brief Getter for the trace clock
+     * @return Time in ns since the start of the clock
+     */
+    static qint64 now();
+
+    /**
+     * @brief Records a span in the buffer of the calling thread
+     * @param name Name of the span, must be a string literal
+     * @param startNs Start time of the trace clock
+     * @param durationNs Duration in ns
+     * @param arg Optional argument, -1 if not used
+     */
+    static void record(const char* name, qint64 startNs, qint64 durationNs, int arg = -1);
+
+    /**
+     * @brief Exports the recorded events of all threads
+     * @return Chrome trace JSON
+     */
+    static QByteArray toChromeJson();
+
+    /**
+     * @brief Discards the recorded events
+     */
+    static void clear();
+
+private:
+    static std::atomic_bool _enabled;
+};
+
+/**
+ * @brief Interaction elements of the flight recorder
+ *
+ * The trace is written to a downloadable file when tracing is switched off and when a frame missed its deadline.
+ */
+class TraceRecorder : public QObject {
+    Q_OBJECT
+
+public:
+    TraceRecorder();
+
+public slots:
+    /**
+     * @brief Writes the trace after a deadline miss
+     *
+     * The trace is written at most once per second, so a series of misses does not keep the file system busy.
+     */
+    void deadlineMissed();
+
+private slots:
+    /**
+     * @brief Setter for the tracing status
+     * @param enable Flag to enable/disable tracing, disabling writes the trace
+     */
+    void enableTracing(bool enable);
+
+private:
+    void writeTrace();
+
+    IDS::NXT::ConfigurableBool _tracing;
+    IDS::NXT::ConfigurableFile _traceFile;
+    QElapsedTimer _lastWrite;
+};
@@ -0,0 +1,24 @@
+#include "verdict.h"
+
+#include <bitset>
+
+VerdictRule::VerdictRule(CnnRoiConfig::Settings::Verdict verdict, int minOk, quint32 roiMask)
+  : _verdict{verdict}
+  , _minOk{minOk}
+  , _roiMask{roiMask} {}
+
+quint32 VerdictRule::roiMask() const {
+    return _roiMask;
+}
+
+bool VerdictRule::isOk(quint32 okMask) const {
+    okMask &= _roiMask;
+    switch (_verdict) {
+    case CnnRoiConfig::Settings::Verdict::Any:
+        return okMask != 0;
+    case CnnRoiConfig::Settings::Verdict::Count:
+        return static_cast<int>(std::bitset<32>(okMask).count()) >= _minOk;
+    default:
+        return okMask == _roiMask;
+    }
+}
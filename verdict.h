@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include "cnnroiconfig.h"
+
+/**
+ * @brief Combines the OK results of the ROIs to the frame verdict
+ *
+ * Every ROI with an OK rule owns one bit of the OK mask, in the order of the ROI names. The verdict is
+ * computed from the mask with a few bit operations, so it can be published at line speed.
+ */
+class VerdictRule {
+public:
+    /**
+     * @brief C'tor for a configuration without OK rules
+     */
+    VerdictRule() = default;
+
+    /**
+     * @brief C'tor
+     * @param verdict Rule which combines the OK results
+     * @param minOk Number of OK ROIs needed by the Count rule
+     * @param roiMask Bits of all ROIs with an OK rule
+     */
+    VerdictRule(CnnRoiConfig::Settings::Verdict verdict, int minOk, quint32 roiMask);
+
+    /**
+     * @brief Getter for the ROIs which are part of the verdict
+     * @return Bits of all ROIs with an OK rule, 0 if the verdict is not used
+     */
+    quint32 roiMask() const;
+
+    /**
+     * @brief Computes the frame verdict
+     * @param okMask Bits of the OK ROIs
+     * @return True if the frame is OK
+     */
+    bool isOk(quint32 okMask) const;
+
+private:
+    CnnRoiConfig::Settings::Verdict _verdict = CnnRoiConfig::Settings::Verdict::All;
+    int _minOk = 1;
+    quint32 _roiMask = 0;
+};
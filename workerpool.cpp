@@ -0,0 +1,89 @@
+#include "workerpool.h"
+
+WorkerPool::WorkerPool(int threadCount) {
+    _threads.reserve(static_cast<size_t>(threadCount));
+    for (auto cnt = 0; cnt < threadCount; cnt++) {
+        _threads.emplace_back(&WorkerPool::work, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _jobAvailable.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(const std::vector<Task>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    Batch batch;
+    batch.pending = static_cast<int>(tasks.size());
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        for (size_t cnt = 1; cnt < tasks.size(); cnt++) {
+            _jobs.push_back(Job{&tasks[cnt], &batch});
+        }
+    }
+    _jobAvailable.notify_all();
+
+    execute(Job{&tasks.front(), &batch});
+
+    // Help with the tasks no worker took yet, then wait for the ones still running
+    std::unique_lock<std::mutex> lock(_lock);
+    while (!_jobs.empty() && _jobs.front().batch == &batch) {
+        const auto job = _jobs.front();
+        _jobs.pop_front();
+        lock.unlock();
+        execute(job);
+        lock.lock();
+    }
+    _batchFinished.wait(lock, [&batch]() { return batch.pending == 0; });
+    lock.unlock();
+
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+int WorkerPool::threadCount() const {
+    return static_cast<int>(_threads.size());
+}
+
+void WorkerPool::work() {
+    std::unique_lock<std::mutex> lock(_lock);
+    for (;;) {
+        _jobAvailable.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+        if (_jobs.empty()) {
+            return;
+        }
+        const auto job = _jobs.front();
+        _jobs.pop_front();
+        lock.unlock();
+        execute(job);
+        lock.lock();
+    }
+}
+
+void WorkerPool::execute(const Job& job) {
+    std::exception_ptr error;
+    try {
+        (*job.task)();
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    if (error && !job.batch->error) {
+        job.batch->error = error;
+    }
+    if (--job.batch->pending == 0) {
+        _batchFinished.notify_all();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of threads which run batches of tasks
+ *
+ * The threads are started once and wait for work in between, so running tasks concurrently does not create
+ * threads per call. The calling thread takes part in a batch and only returns when all of its tasks are finished.
+ */
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief C'tor
+     * @param threadCount Number of worker threads besides the calling thread
+     */
+    explicit WorkerPool(int threadCount);
+
+    /**
+     * @brief D'tor, waits for the running tasks and stops the threads
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Runs tasks concurrently and waits until all of them are finished
+     * @param tasks Tasks, the first one runs on the calling thread
+     *
+     * An exception of a task is rethrown here after all tasks are finished, the first one if several tasks failed.
+     */
+    void run(const std::vector<Task>& tasks);
+
+    /**
+     * @brief Getter for the number of worker threads
+     */
+    int threadCount() const;
+
+private:
+    struct Batch {
+        int pending = 0;
+        std::exception_ptr error;
+    };
+
+    struct Job {
+        const Task* task;
+        Batch* batch;
+    };
+
+    void work();
+    void execute(const Job& job);
+
+    std::mutex _lock;
+    std::condition_variable _jobAvailable;
+    std::condition_variable _batchFinished;
+    std::deque<Job> _jobs;
+    bool _stop = false;
+    std::vector<std::thread> _threads;
+};